@@ -0,0 +1,632 @@
+#include <iostream>
+#include <iomanip>
+#include <set>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <algorithm>
+#include <thread>
+
+#include <Interval.hpp>
+#include <IntervalTree.hpp>
+#include <IntervalCoverage.hpp>
+#include <IntrusiveIntervalTree.hpp>
+#include <OccupancyBitmap.hpp>
+#include <OverlapCache.hpp>
+#include <NestedContainmentList.hpp>
+#include <overlap_join.hpp>
+#include <interval_operations.hpp>
+#include <interval_algebra.hpp>
+
+#include "perf_counters.hpp"
+
+typedef unsigned long IntType;
+typedef IntervalT<IntType> Interval;
+
+/**
+ * Keeps results alive, so the optimizer cannot drop the work.
+ */
+static std::size_t sink = 0;
+
+/**
+ * Hardware counters read around every workload with --perf, nullptr otherwise.
+ */
+static PerfCounters* counters = nullptr;
+
+/**
+ * Runs the workload once and prints nanoseconds per operation, with --perf also
+ * the hardware counters per operation ("-" for the ones that are not available).
+ */
+template<typename Workload>
+void run(const std::string& name, std::size_t operations, Workload workload) {
+    using std::chrono::steady_clock;
+    using std::chrono::duration_cast;
+    using std::chrono::nanoseconds;
+
+    if (counters != nullptr) {
+        counters->start();
+    }
+    steady_clock::time_point start = steady_clock::now();
+    workload();
+    steady_clock::time_point end = steady_clock::now();
+    if (counters != nullptr) {
+        counters->stop();
+    }
+    double ns = static_cast<double>(duration_cast<nanoseconds>(end - start).count());
+    std::cout << std::left << std::setw(48) << name << std::right << std::setw(12)
+            << std::fixed << std::setprecision(1) << ns / operations << " ns/op";
+    for (int e = 0; counters != nullptr && e < PerfCounters::EVENTS; ++e) {
+        double count = counters->count(static_cast<PerfCounters::Event>(e));
+        std::cout << std::setw(12);
+        if (count < 0.0) {
+            std::cout << "-";
+        } else {
+            std::cout << count / operations;
+        }
+    }
+    std::cout << std::endl;
+}
+
+/**
+ * Short intervals spread over the coordinate space, little nesting.
+ */
+std::vector<Interval> flat(std::size_t n, std::mt19937_64& random) {
+    std::vector<Interval> res;
+    std::uniform_int_distribution<IntType> start(0, n * 100);
+    std::uniform_int_distribution<IntType> length(1, 100);
+    for (std::size_t i = 0; i < n; ++i) {
+        IntType s = start(random);
+        res.push_back(Interval::valueOf(s, s + length(random)));
+    }
+    return res;
+}
+
+/**
+ * One interval of a hundred encloses a long stretch of the space, the rest are short.
+ * The long ones keep max_ high in most subtrees of IntervalTree.
+ */
+std::vector<Interval> nested(std::size_t n, std::mt19937_64& random) {
+    std::vector<Interval> res;
+    std::uniform_int_distribution<IntType> start(0, n * 100);
+    std::uniform_int_distribution<IntType> length(1, 100);
+    std::uniform_int_distribution<IntType> enclosing(n * 10, n * 50);
+    for (std::size_t i = 0; i < n; ++i) {
+        IntType s = start(random);
+        res.push_back(Interval::valueOf(s, s + (i % 100 == 0 ? enclosing(random) : length(random))));
+    }
+    return res;
+}
+
+std::vector<Interval> queries(std::size_t n, std::size_t count, std::mt19937_64& random) {
+    std::vector<Interval> res;
+    std::uniform_int_distribution<IntType> start(0, n * 100);
+    for (std::size_t i = 0; i < count; ++i) {
+        IntType s = start(random);
+        res.push_back(Interval::valueOf(s, s + 100));
+    }
+    return res;
+}
+
+/**
+ * IntervalTree::overlapSearch, one query at a time and batched,
+ * against NestedContainmentList::overlapSearch.
+ */
+void benchOverlap(const std::string& dataset, const std::vector<Interval>& input, const std::vector<Interval>& windows) {
+    IntervalTree<IntType> tree;
+    for (auto i: input) {
+        tree.insert(i);
+    }
+    NestedContainmentList<IntType> list(tree);
+
+    run(dataset + ": IntervalTree::overlapSearch", windows.size(), [&]() {
+        std::set<Interval> res;
+        for (auto w: windows) {
+            tree.overlapSearch(w, res);
+            sink += res.size();
+            res.clear();
+        }
+    });
+    run(dataset + ": IntervalTree::overlapSearch, vector", windows.size(), [&]() {
+        std::vector<Interval> res;
+        for (auto w: windows) {
+            tree.overlapSearch(w, res);
+            sink += res.size();
+            res.clear();
+        }
+    });
+    run(dataset + ": IntervalTree::batchOverlapSearch", windows.size(), [&]() {
+        tree.batchOverlapSearch(windows.begin(), windows.end(), [](std::size_t, const Interval&) {
+            ++sink;
+        });
+    });
+    run(dataset + ": NestedContainmentList::overlapSearch", windows.size(), [&]() {
+        std::set<Interval> res;
+        for (auto w: windows) {
+            list.overlapSearch(w, res);
+            sink += res.size();
+            res.clear();
+        }
+    });
+}
+
+/**
+ * Lookups of every start in increasing order, as reads going through an extent map.
+ */
+void benchSequential(const std::vector<Interval>& input) {
+    IntervalTree<IntType> tree;
+    for (auto i: input) {
+        tree.insert(i);
+    }
+    std::vector<IntType> offsets;
+    tree.forEach([&offsets](const Interval& i) {
+        offsets.push_back(i.start());
+    });
+
+    run("sequential: IntervalTree::search", offsets.size(), [&]() {
+        for (auto offset: offsets) {
+            sink += tree.search(offset).end();
+        }
+    });
+    run("sequential: IntervalTree::search with finger", offsets.size(), [&]() {
+        IntervalTree<IntType>::Finger finger;
+        for (auto offset: offsets) {
+            sink += tree.search(offset, finger).end();
+        }
+    });
+}
+
+/**
+ * A delta as large as the index merged in: insert one by one against mergeFrom.
+ */
+void benchMerge(const std::vector<Interval>& input) {
+    std::size_t split = input.size() / 2;
+    IntervalTree<IntType> main, byInsert, byMerge;
+    for (std::size_t i = 0; i < split; ++i) {
+        main.insert(input[i]);
+    }
+    byInsert = main.clone();
+    byMerge = std::move(main);
+
+    run("merge delta: IntervalTree::insert", input.size() - split, [&]() {
+        for (std::size_t i = split; i < input.size(); ++i) {
+            byInsert.insert(input[i]);
+        }
+    });
+    IntervalTree<IntType> delta;
+    for (std::size_t i = split; i < input.size(); ++i) {
+        delta.insert(input[i]);
+    }
+    run("merge delta: IntervalTree::mergeFrom", input.size() - split, [&]() {
+        byMerge.mergeFrom(std::move(delta));
+    });
+    sink += byInsert.isValid() + byMerge.isValid();
+}
+
+/**
+ * All overlapping pairs of two sets: overlapSearch for every interval against overlapJoin.
+ */
+void benchJoin(const std::vector<Interval>& first, const std::vector<Interval>& second) {
+    IntervalTree<IntType> a, b;
+    for (auto i: first) {
+        a.insert(i);
+    }
+    for (auto i: second) {
+        b.insert(i);
+    }
+    run("join: IntervalTree::overlapSearch per interval", first.size(), [&]() {
+        std::vector<Interval> res;
+        a.forEach([&](const Interval& i) {
+            b.overlapSearch(i, res);
+            sink += res.size();
+            res.clear();
+        });
+    });
+    run("join: overlapJoin", first.size(), [&]() {
+        overlapJoin(a, b, [](std::size_t, const Interval&, const Interval&) {
+            ++sink;
+        });
+    });
+    unsigned threads = std::max(2U, std::thread::hardware_concurrency());
+    std::vector<std::size_t> counts(threads);
+    run("join: overlapJoin, " + std::to_string(threads) + " threads", first.size(), [&]() {
+        overlapJoin(a, b, [&counts](std::size_t part, const Interval&, const Interval&) {
+            ++counts[part];
+        }, threads);
+    });
+    for (auto c: counts) {
+        sink += c;
+    }
+}
+
+/**
+ * Every interval grows three times, as extents with appends: remove and insert
+ * against updateEnd through a handle.
+ */
+void benchAppend(const std::vector<Interval>& input) {
+    IntervalTree<IntType> byReinsert, byHandle;
+    for (auto i: input) {
+        byReinsert.insert(i);
+        byHandle.insert(i);
+    }
+    std::vector<IntType> starts;
+    byHandle.forEach([&starts](const Interval& i) {
+        starts.push_back(i.start());
+    });
+    std::mt19937_64 random(7);
+    std::shuffle(starts.begin(), starts.end(), random);
+
+    run("append: IntervalTree::remove + insert", 3 * starts.size(), [&]() {
+        for (IntType grow = 1; grow <= 3; ++grow) {
+            for (auto s: starts) {
+                Interval i = byReinsert.search(s);
+                byReinsert.remove(i);
+                byReinsert.insert(Interval::valueOf(s, i.end() + grow));
+            }
+        }
+    });
+    run("append: IntervalTree::find + updateEnd", 3 * starts.size(), [&]() {
+        for (IntType grow = 1; grow <= 3; ++grow) {
+            for (auto s: starts) {
+                IntervalTree<IntType>::Handle h = byHandle.find(s);
+                byHandle.updateEnd(h, h->end() + grow);
+            }
+        }
+    });
+    sink += byReinsert.isValid() + byHandle.isValid();
+}
+
+/**
+ * Covered length and peak depth of wide windows: overlapSearch and a sweep over the
+ * results against IntervalCoverage.
+ */
+void benchCoverage(const std::vector<Interval>& input, const std::vector<Interval>& windows) {
+    IntervalTree<IntType> tree;
+    IntervalCoverage<IntType> coverage;
+    for (auto i: input) {
+        if (tree.insert(i)) {
+            coverage.insert(i);
+        }
+    }
+    std::vector<Interval> wide;
+    for (auto w: windows) {
+        wide.push_back(Interval::valueOf(w.start(), w.start() + 100000));
+    }
+    run("coverage: overlapSearch + union", wide.size(), [&]() {
+        std::vector<Interval> res;
+        for (auto w: wide) {
+            tree.overlapSearch(w, res);
+            IntType covered = 0, reach = w.start();
+            for (auto& i: res) {
+                IntType from = std::max(reach, i.start()), to = std::min(i.end(), w.end());
+                if (from < to) {
+                    covered += to - from;
+                    reach = to;
+                }
+            }
+            sink += covered;
+            res.clear();
+        }
+    });
+    run("coverage: IntervalCoverage::coveredLength", wide.size(), [&]() {
+        for (auto w: wide) {
+            sink += coverage.coveredLength(w);
+        }
+    });
+    run("peak: overlapSearch + sweep", wide.size(), [&]() {
+        std::vector<Interval> res;
+        std::vector<std::pair<IntType, long>> events;
+        for (auto w: wide) {
+            tree.overlapSearch(w, res);
+            for (auto& i: res) {
+                events.push_back(std::make_pair(std::max(i.start(), w.start()), 1L));
+                events.push_back(std::make_pair(i.end(), -1L));
+            }
+            std::sort(events.begin(), events.end());
+            long depth = 0, peak = 0;
+            for (auto& e: events) {
+                depth += e.second;
+                peak = std::max(peak, depth);
+            }
+            sink += peak;
+            res.clear();
+            events.clear();
+        }
+    });
+    run("peak: IntervalCoverage::maxDepth", wide.size(), [&]() {
+        for (auto w: wide) {
+            sink += coverage.maxDepth(w);
+        }
+    });
+}
+
+/**
+ * Interval with the links of IntrusiveIntervalTree.
+ */
+struct HookedInterval: IntrusiveIntervalHook<IntType, HookedInterval> {
+    IntType start_;
+    IntType end_;
+
+    IntType start() const {
+        return start_;
+    }
+    IntType end() const {
+        return end_;
+    }
+};
+
+/**
+ * Insert and remove everything: a node allocated per interval against items linked in place.
+ */
+void benchIntrusive(const std::vector<Interval>& input) {
+    IntervalTree<IntType> tree;
+    run("insert/remove: IntervalTree", input.size(), [&]() {
+        for (auto i: input) {
+            tree.insert(i);
+        }
+        for (auto i: input) {
+            tree.remove(i);
+        }
+    });
+    std::vector<HookedInterval> items(input.size());
+    for (std::size_t k = 0; k < input.size(); ++k) {
+        items[k].start_ = input[k].start();
+        items[k].end_ = input[k].end();
+    }
+    IntrusiveIntervalTree<IntType, HookedInterval> intrusive;
+    run("insert/remove: IntrusiveIntervalTree", input.size(), [&]() {
+        std::vector<bool> linked(items.size());
+        for (std::size_t k = 0; k < items.size(); ++k) {
+            linked[k] = intrusive.insert(items[k]);
+        }
+        for (std::size_t k = 0; k < items.size(); ++k) {
+            if (linked[k]) {
+                intrusive.remove(items[k]);
+            }
+        }
+    });
+    sink += tree.empty() + intrusive.empty();
+}
+
+/**
+ * Intervals in every other block of the space, queries into the empty blocks between
+ * them, so the tree descends to the gap: overlapSearch alone against OccupancyBitmap first.
+ */
+void benchOccupancy(std::size_t n, std::size_t count) {
+    const IntType block = 10000;
+    IntervalTree<IntType> tree;
+    OccupancyBitmap<IntType> occupancy(0, 100, n);
+    std::mt19937_64 random(13);
+    std::uniform_int_distribution<IntType> start(0, n * 50);
+    std::uniform_int_distribution<IntType> length(1, 100);
+    for (std::size_t k = 0; k < n; ++k) {
+        IntType s = start(random);
+        s = s / block * 2 * block + s % block;
+        Interval i = Interval::valueOf(s, s + length(random));
+        if (tree.insert(i)) {
+            occupancy.insert(i);
+        }
+    }
+    std::vector<Interval> windows;
+    std::uniform_int_distribution<IntType> gap(0, n * 50 / block - 1);
+    std::uniform_int_distribution<IntType> offset(200, block - 300);
+    for (std::size_t k = 0; k < count; ++k) {
+        IntType s = (2 * gap(random) + 1) * block + offset(random);
+        windows.push_back(Interval::valueOf(s, s + 100));
+    }
+
+    run("empty regions: IntervalTree::overlapSearch", windows.size(), [&]() {
+        std::vector<Interval> res;
+        for (auto w: windows) {
+            tree.overlapSearch(w, res);
+            sink += res.size();
+            res.clear();
+        }
+    });
+    run("empty regions: OccupancyBitmap + overlapSearch", windows.size(), [&]() {
+        std::vector<Interval> res;
+        for (auto w: windows) {
+            if (occupancy.mayOverlap(w)) {
+                tree.overlapSearch(w, res);
+                sink += res.size();
+                res.clear();
+            }
+        }
+    });
+}
+
+/**
+ * A dashboard: the same 16 windows over and over, now and then an insertion.
+ * overlapSearch every time against OverlapCache.
+ */
+void benchHotWindows(const std::vector<Interval>& input, std::size_t count) {
+    IntervalTree<IntType> tree;
+    for (auto i: input) {
+        tree.insert(i);
+    }
+    std::mt19937_64 random(17);
+    std::vector<Interval> hot = queries(input.size(), 16, random);
+    std::vector<Interval> inserts = flat(count, random);
+    const std::size_t operations = 10 * count;
+
+    run("hot windows: IntervalTree::overlapSearch", operations, [&]() {
+        std::vector<Interval> res;
+        for (std::size_t k = 0; k < operations; ++k) {
+            if (k % 1000 == 0) {
+                tree.insert(inserts[k / 1000]);
+            }
+            tree.overlapSearch(hot[k % hot.size()], res);
+            sink += res.size();
+            res.clear();
+        }
+    });
+    OverlapCache<IntType> cache(tree, hot.size());
+    run("hot windows: OverlapCache::overlapSearch", operations, [&]() {
+        for (std::size_t k = 0; k < operations; ++k) {
+            if (k % 1000 == 0) {
+                tree.insert(inserts[count / 2 + k / 1000]);
+            }
+            sink += cache.overlapSearch(hot[k % hot.size()]).size();
+        }
+    });
+}
+
+/**
+ * Union of two sorted interval lists over the same space, a fine one and a coarse one
+ * of every hundredth interval of the second input: merged one Interval at a time with set_union (valueOf for every merge),
+ * against sorted_union over the bounds.
+ */
+void benchAlgebra(const std::vector<Interval>& first, const std::vector<Interval>& second) {
+    std::vector<Interval> lists[2] = {first, std::vector<Interval>()};
+    for (std::size_t k = 0; k < second.size(); k += 100) {
+        lists[1].push_back(second[k]);
+    }
+    std::vector<IntType> bounds[2][2];
+    for (int l = 0; l < 2; ++l) {
+        std::sort(lists[l].begin(), lists[l].end(), [](const Interval& x, const Interval& y) {
+            return x.start() < y.start() || (x.start() == y.start() && x.end() < y.end());
+        });
+        for (auto i: lists[l]) {
+            bounds[l][0].push_back(i.start());
+            bounds[l][1].push_back(i.end());
+        }
+        std::size_t size = sorted_normalize(bounds[l][0].data(), bounds[l][1].data(), lists[l].size());
+        bounds[l][0].resize(size);
+        bounds[l][1].resize(size);
+        lists[l].clear();
+        for (std::size_t k = 0; k < size; ++k) {
+            lists[l].push_back(Interval::valueOf(bounds[l][0][k], bounds[l][1][k]));
+        }
+    }
+    const std::size_t operations = lists[0].size() + lists[1].size();
+
+    run("union of sorted lists: set_union per Interval", operations, [&]() {
+        std::vector<Interval> res;
+        res.reserve(operations);
+        std::size_t i = 0, j = 0;
+        while (i < lists[0].size() || j < lists[1].size()) {
+            bool taken = j == lists[1].size() || (i < lists[0].size() && !(lists[1][j].start() < lists[0][i].start()));
+            const Interval& next = taken ? lists[0][i++] : lists[1][j++];
+            if (!res.empty() && overlap(res.back(), next)) {
+                res.back() = set_union(res.back(), next);
+            } else if (!res.empty() && res.back().end() == next.start()) {
+                res.back() = Interval::valueOf(res.back().start(), next.end());
+            } else {
+                res.push_back(next);
+            }
+        }
+        sink += res.size();
+    });
+    std::vector<IntType> starts(operations), ends(operations);
+    run("union of sorted lists: sorted_union", operations, [&]() {
+        sink += sorted_union(IntervalList<const IntType>{bounds[0][0].data(), bounds[0][1].data(), bounds[0][0].size()},
+                IntervalList<const IntType>{bounds[1][0].data(), bounds[1][1].data(), bounds[1][0].size()},
+                starts.data(), ends.data());
+    });
+}
+
+/**
+ * One balancing policy of IntervalTree: random insertions, then mixes of reads
+ * (overlapSearch of a window) and writes (an interval moves: remove and insert)
+ * at 90/10, 50/50 and 10/90 percent. The tree keeps its size.
+ */
+template<typename Balance>
+void benchBalance(const std::string& policy, const std::vector<Interval>& input, const std::vector<Interval>& windows) {
+    typedef IntervalTree<IntType, Interval, std::allocator<Interval>, NoAugmentation, Balance> Tree;
+
+    Tree tree;
+    run("balance: " + policy + " insert", input.size(), [&]() {
+        for (auto i: input) {
+            tree.insert(i);
+        }
+    });
+    std::vector<Interval> present;
+    tree.forEach([&present](const Interval& i) {
+        present.push_back(i);
+    });
+
+    const std::size_t operations = 4 * windows.size();
+    std::mt19937_64 random(11);
+    std::uniform_int_distribution<std::size_t> victim(0, present.size() - 1);
+    std::vector<std::size_t> victims(operations);
+    std::generate(victims.begin(), victims.end(), [&]() {
+        return victim(random);
+    });
+    std::vector<Interval> moves = flat(operations, random);
+
+    for (unsigned reads: {90U, 50U, 10U}) {
+        std::string mix = std::to_string(reads) + "/" + std::to_string(100 - reads);
+        run("balance: " + policy + " " + mix + " read/write", operations, [&]() {
+            std::vector<Interval> res;
+            for (std::size_t k = 0; k < operations; ++k) {
+                if (k % 100 < reads) {
+                    tree.overlapSearch(windows[k % windows.size()], res);
+                    sink += res.size();
+                    res.clear();
+                    continue;
+                }
+                Interval& old = present[victims[k]];
+                tree.remove(old);
+                if (tree.insert(moves[k])) {
+                    old = moves[k];
+                } else {
+                    tree.insert(old);
+                }
+            }
+        });
+    }
+    sink += tree.isValid();
+}
+
+/**
+ * bench_tree [--perf] [intervals] [queries]
+ *
+ * --perf adds hardware counters per operation, the run goes on with timings only
+ * when no counter can be opened (no PMU in a VM, perf_event_paranoid > 2, not Linux).
+ */
+int main(int argc, char **argv) {
+    PerfCounters perf;
+    int arg = 1;
+    if (argc > arg && std::string(argv[arg]) == "--perf") {
+        ++arg;
+        if (perf.available()) {
+            counters = &perf;
+        } else {
+            std::cout << "hardware counters are not available (" << perf.error() << "), timings only" << std::endl;
+        }
+    }
+    std::size_t n = argc > arg ? std::strtoul(argv[arg], nullptr, 10) : 100000;
+    std::size_t count = argc > arg + 1 ? std::strtoul(argv[arg + 1], nullptr, 10) : 10000;
+
+    std::mt19937_64 random(42);
+    std::vector<Interval> windows = queries(n, count, random);
+
+    std::cout << n << " intervals, " << count << " queries" << std::endl;
+    if (counters != nullptr) {
+        std::cout << std::left << std::setw(48) << "" << std::right << std::setw(18) << "ns/op";
+        for (int e = 0; e < PerfCounters::EVENTS; ++e) {
+            std::cout << std::setw(12) << PerfCounters::name(static_cast<PerfCounters::Event>(e));
+        }
+        std::cout << std::endl;
+    }
+    benchOverlap("flat", flat(n, random), windows);
+    benchOverlap("nested", nested(n, random), windows);
+    benchSequential(flat(n, random));
+    benchMerge(flat(n, random));
+    benchJoin(flat(n, random), flat(n, random));
+    benchIntrusive(flat(n, random));
+    benchAppend(flat(n, random));
+    benchCoverage(nested(n, random), windows);
+    benchOccupancy(n, count);
+    benchHotWindows(nested(n, random), count);
+    benchAlgebra(flat(n * 10, random), flat(n * 10, random));
+    std::vector<Interval> mixed = flat(n, random);
+    benchBalance<RedBlackBalance>("red-black", mixed, windows);
+    benchBalance<AvlBalance>("AVL", mixed, windows);
+    benchBalance<WavlBalance>("WAVL", mixed, windows);
+    benchBalance<TreapBalance>("treap", mixed, windows);
+
+    std::cout << "(" << sink << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * perf_counters.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: andrei
+ */
+
+#ifndef PERF_COUNTERS_HPP_
+#define PERF_COUNTERS_HPP_
+
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Hardware counters of the calling thread and the threads it starts, read with Linux
+ * perf_event_open around a workload: cycles, instructions, L1d, LLC and dTLB read
+ * misses, branch misses.
+ *
+ * Every counter is opened on its own, so the ones the CPU or the hypervisor does not
+ * have are skipped and the rest still count. The kernel is excluded, which is allowed
+ * with perf_event_paranoid up to 2. When the kernel multiplexes the counters, the
+ * counts are scaled by the time enabled over the time running.
+ * Elsewhere than on Linux nothing is available.
+ */
+class PerfCounters {
+public:
+    enum Event {
+        CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, BRANCH_MISSES, DTLB_MISSES, EVENTS
+    };
+
+    static const char* name(Event event) {
+        static const char* const names[EVENTS] = {"cycles", "instr", "L1d-miss", "LLC-miss", "br-miss", "dTLB-miss"};
+        return names[event];
+    }
+
+private:
+    int fds_[EVENTS];
+    double counts_[EVENTS];
+    /**
+     * why the first counter that failed could not be opened.
+     */
+    std::string error_;
+
+#ifdef __linux__
+    static int open(std::uint32_t type, std::uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.inherit = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    static std::uint64_t cacheMiss(std::uint64_t cache) {
+        return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    }
+#endif
+
+public:
+    PerfCounters() {
+        for (int e = 0; e < EVENTS; ++e) {
+            fds_[e] = -1;
+            counts_[e] = -1.0;
+        }
+#ifdef __linux__
+        const std::uint32_t types[EVENTS] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+                PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE};
+        const std::uint64_t configs[EVENTS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                cacheMiss(PERF_COUNT_HW_CACHE_L1D), cacheMiss(PERF_COUNT_HW_CACHE_LL),
+                PERF_COUNT_HW_BRANCH_MISSES, cacheMiss(PERF_COUNT_HW_CACHE_DTLB)};
+        for (int e = 0; e < EVENTS; ++e) {
+            fds_[e] = open(types[e], configs[e]);
+            if (fds_[e] < 0 && error_.empty()) {
+                error_ = std::string(name(static_cast<Event>(e))) + ": " + std::strerror(errno);
+            }
+        }
+#else
+        error_ = "perf_event_open is Linux only";
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (int e = 0; e < EVENTS; ++e) {
+            if (fds_[e] >= 0) {
+                close(fds_[e]);
+            }
+        }
+#endif
+    }
+
+    /**
+     * at least one counter is open.
+     */
+    bool available() const {
+        for (int e = 0; e < EVENTS; ++e) {
+            if (fds_[e] >= 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool available(Event event) const {
+        return fds_[event] >= 0;
+    }
+
+    const std::string& error() const {
+        return error_;
+    }
+
+    void start() {
+#ifdef __linux__
+        for (int e = 0; e < EVENTS; ++e) {
+            if (fds_[e] >= 0) {
+                ioctl(fds_[e], PERF_EVENT_IOC_RESET, 0);
+                ioctl(fds_[e], PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    void stop() {
+#ifdef __linux__
+        for (int e = 0; e < EVENTS; ++e) {
+            if (fds_[e] < 0) {
+                continue;
+            }
+            ioctl(fds_[e], PERF_EVENT_IOC_DISABLE, 0);
+            /*
+             * value, time enabled, time running.
+             */
+            std::uint64_t values[3] = {0, 0, 0};
+            if (read(fds_[e], values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)) || values[2] == 0) {
+                counts_[e] = -1.0;
+            } else {
+                counts_[e] = static_cast<double>(values[0]) * values[1] / values[2];
+            }
+        }
+#endif
+    }
+
+    /**
+     * The count of the event between the last start and stop, -1 if it is not available.
+     */
+    double count(Event event) const {
+        return counts_[event];
+    }
+};
+
+#endif /* PERF_COUNTERS_HPP_ */
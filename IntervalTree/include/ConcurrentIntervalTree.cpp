@@ -0,0 +1,405 @@
+#ifndef CONCURRENT_INTERVAL_TREE_CPP
+#define CONCURRENT_INTERVAL_TREE_CPP
+
+#include <stack>
+
+/**
+ * height(x) = 1 + max(height(left(x)), height(right(x)))
+ * max(x) = max(rightendpoint(x), max(left(x)), max(right(x)))
+ * min(x) = min(leftendpoint(x), min(left(x)), min(right(x)))
+ */
+template<typename T, typename Interval>
+void ConcurrentIntervalTree<T, Interval>::update(NodePtr node) {
+    using std::max;
+    using std::min;
+
+    node->height_ = 1 + max(height(node->left_), height(node->right_));
+    node->max_ = node->key_.end();
+    node->min_ = node->key_.start();
+    if (node->left_ != nullptr) {
+        node->max_ = max(node->max_, node->left_->max_);
+        node->min_ = min(node->min_, node->left_->min_);
+    }
+    if (node->right_ != nullptr) {
+        node->max_ = max(node->max_, node->right_->max_);
+        node->min_ = min(node->min_, node->right_->min_);
+    }
+}
+
+template<typename T, typename Interval>
+typename ConcurrentIntervalTree<T, Interval>::NodePtr ConcurrentIntervalTree<T, Interval>::writable(NodePtr node) {
+    if (node->generation_ == generation_) {
+        return node;
+    }
+    NodePtr copy = allocate(*node);
+    unlinked_.push_back(node);
+    return copy;
+}
+
+template<typename T, typename Interval>
+void ConcurrentIntervalTree<T, Interval>::discard(NodePtr node) {
+    if (node->generation_ == generation_) {
+        discarded_.push_back(node);
+    } else {
+        unlinked_.push_back(node);
+    }
+}
+
+/**
+ * The slot is reserved before the allocation, so every node of the current generation
+ * is in created_ even if the write throws later.
+ */
+template<typename T, typename Interval>
+template<typename Source>
+typename ConcurrentIntervalTree<T, Interval>::NodePtr ConcurrentIntervalTree<T, Interval>::allocate(const Source& source) {
+    created_.push_back(nullptr);
+    try {
+        created_.back() = new OrdinaryNode(source, generation_);
+    } catch (...) {
+        created_.pop_back();
+        throw;
+    }
+    return created_.back();
+}
+
+/**
+ * The published root still references every unlinked node, only the private copies go.
+ */
+template<typename T, typename Interval>
+void ConcurrentIntervalTree<T, Interval>::abandon() {
+    for (typename std::vector<NodePtr>::iterator i = created_.begin(); i != created_.end(); ++i) {
+        delete *i;
+    }
+    created_.clear();
+    discarded_.clear();
+    unlinked_.clear();
+}
+
+/**
+ *  parent x    parent x
+ *   |            |
+ *   x            y
+ *  / \          / \
+ * a   \        /   c
+ *      y      x
+ *     / \    / \
+ *    b   c  a   b
+ */
+template<typename T, typename Interval>
+typename ConcurrentIntervalTree<T, Interval>::NodePtr ConcurrentIntervalTree<T, Interval>::rotateLeft(NodePtr x) {
+    NodePtr y = writable(x->right_);
+    x->right_ = y->left_;
+    update(x);
+    y->left_ = x;
+    update(y);
+    return y;
+}
+
+/**
+ *   parent x  parent x
+ *       |        |
+ *       x        y
+ *      / \      / \
+ *     /   c    a   \
+ *    y              x
+ *   / \            / \
+ *  a   b          b   c
+ */
+template<typename T, typename Interval>
+typename ConcurrentIntervalTree<T, Interval>::NodePtr ConcurrentIntervalTree<T, Interval>::rotateRight(NodePtr x) {
+    NodePtr y = writable(x->left_);
+    x->left_ = y->right_;
+    update(x);
+    y->right_ = x;
+    update(y);
+    return y;
+}
+
+template<typename T, typename Interval>
+typename ConcurrentIntervalTree<T, Interval>::NodePtr ConcurrentIntervalTree<T, Interval>::balance(NodePtr node) {
+    update(node);
+    int factor = height(node->left_) - height(node->right_);
+    if (factor > 1) {
+        if (height(node->left_->left_) < height(node->left_->right_)) {
+            node->left_ = rotateLeft(writable(node->left_));
+        }
+        return rotateRight(node);
+    }
+    if (factor < -1) {
+        if (height(node->right_->right_) < height(node->right_->left_)) {
+            node->right_ = rotateRight(writable(node->right_));
+        }
+        return rotateLeft(node);
+    }
+    return node;
+}
+
+/**
+ * Nodes are copied on the way back from the recursion and only if the subtree changed,
+ * so a duplicate key costs no allocation.
+ */
+template<typename T, typename Interval>
+typename ConcurrentIntervalTree<T, Interval>::NodePtr ConcurrentIntervalTree<T, Interval>::insert(NodePtr node, const Interval& key) {
+    if (node == nullptr) {
+        return allocate(key);
+    }
+    if (key < node->key_) {
+        NodePtr left = insert(node->left_, key);
+        if (left == node->left_) {
+            return node;
+        }
+        NodePtr copy = writable(node);
+        copy->left_ = left;
+        return balance(copy);
+    } else if (key > node->key_) {
+        NodePtr right = insert(node->right_, key);
+        if (right == node->right_) {
+            return node;
+        }
+        NodePtr copy = writable(node);
+        copy->right_ = right;
+        return balance(copy);
+    }
+    return node;
+}
+
+template<typename T, typename Interval>
+typename ConcurrentIntervalTree<T, Interval>::NodePtr ConcurrentIntervalTree<T, Interval>::removeMinimum(NodePtr node, NodePtr& minimum) {
+    if (node->left_ == nullptr) {
+        minimum = node;
+        return node->right_;
+    }
+    NodePtr copy = writable(node);
+    copy->left_ = removeMinimum(copy->left_, minimum);
+    return balance(copy);
+}
+
+template<typename T, typename Interval>
+typename ConcurrentIntervalTree<T, Interval>::NodePtr ConcurrentIntervalTree<T, Interval>::remove(NodePtr node, const Interval& key) {
+    if (node == nullptr) {
+        return nullptr;
+    }
+    if (key < node->key_) {
+        NodePtr left = remove(node->left_, key);
+        if (left == node->left_) {
+            return node;
+        }
+        NodePtr copy = writable(node);
+        copy->left_ = left;
+        return balance(copy);
+    } else if (key > node->key_) {
+        NodePtr right = remove(node->right_, key);
+        if (right == node->right_) {
+            return node;
+        }
+        NodePtr copy = writable(node);
+        copy->right_ = right;
+        return balance(copy);
+    }
+
+    NodePtr left = node->left_;
+    NodePtr right = node->right_;
+    discard(node);
+    if (left == nullptr) {
+        return right;
+    }
+    if (right == nullptr) {
+        return left;
+    }
+    /*
+     * the successor takes the place of the removed node.
+     */
+    NodePtr successor(nullptr);
+    right = removeMinimum(right, successor);
+    successor = writable(successor);
+    successor->left_ = left;
+    successor->right_ = right;
+    return balance(successor);
+}
+
+/**
+ * The root is stored before the epoch is read, so a reader that announces a newer
+ * epoch than the tag of an unlinked node also loads the new root.
+ * Nothing throws after the store: retired_ is grown first.
+ */
+template<typename T, typename Interval>
+void ConcurrentIntervalTree<T, Interval>::publish(NodePtr root) {
+    retired_.reserve(retired_.size() + unlinked_.size());
+    root_.store(root);
+    unsigned long long epoch = domain_.epoch();
+    for (typename std::vector<NodePtr>::iterator i = unlinked_.begin(); i != unlinked_.end(); ++i) {
+        retired_.push_back(std::make_pair(*i, epoch));
+    }
+    unlinked_.clear();
+    for (typename std::vector<NodePtr>::iterator i = discarded_.begin(); i != discarded_.end(); ++i) {
+        delete *i;
+    }
+    discarded_.clear();
+    created_.clear();
+    domain_.advance();
+    reclaim();
+}
+
+template<typename T, typename Interval>
+void ConcurrentIntervalTree<T, Interval>::reclaim() {
+    if (retired_.empty()) {
+        return;
+    }
+    unsigned long long oldest = domain_.oldest();
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < retired_.size(); ++i) {
+        if (retired_[i].second < oldest) {
+            delete retired_[i].first;
+        } else {
+            retired_[kept++] = retired_[i];
+        }
+    }
+    retired_.resize(kept);
+}
+
+template<typename T, typename Interval>
+void ConcurrentIntervalTree<T, Interval>::destroy(NodePtr node) {
+    if (node == nullptr) {
+        return;
+    }
+    destroy(node->left_);
+    destroy(node->right_);
+    delete node;
+}
+
+template<typename T, typename Interval>
+ConcurrentIntervalTree<T, Interval>::~ConcurrentIntervalTree() {
+    destroy(root_.load());
+    for (std::size_t i = 0; i < retired_.size(); ++i) {
+        delete retired_[i].first;
+    }
+}
+
+template<typename T, typename Interval>
+bool ConcurrentIntervalTree<T, Interval>::insert(const Interval& key) {
+    std::lock_guard<std::mutex> lock(writer_);
+    ++generation_;
+    abandon();
+    NodePtr root = root_.load();
+    try {
+        NodePtr updated = insert(root, key);
+        if (updated == root) {
+            return false;
+        }
+        publish(updated);
+    } catch (...) {
+        abandon();
+        throw;
+    }
+    return true;
+}
+
+template<typename T, typename Interval>
+bool ConcurrentIntervalTree<T, Interval>::remove(const Interval& key) {
+    std::lock_guard<std::mutex> lock(writer_);
+    ++generation_;
+    abandon();
+    NodePtr root = root_.load();
+    try {
+        NodePtr updated = remove(root, key);
+        if (updated == root) {
+            return false;
+        }
+        publish(updated);
+    } catch (...) {
+        abandon();
+        throw;
+    }
+    return true;
+}
+
+template<typename T, typename Interval>
+void ConcurrentIntervalTree<T, Interval>::clear() {
+    std::lock_guard<std::mutex> lock(writer_);
+    ++generation_;
+    NodePtr root = root_.load();
+    if (root == nullptr) {
+        return;
+    }
+    abandon();
+    try {
+        std::stack<NodePtr> s;
+        s.push(root);
+        while (!s.empty()) {
+            NodePtr node = s.top();
+            s.pop();
+            if (node->left_ != nullptr) {
+                s.push(node->left_);
+            }
+            if (node->right_ != nullptr) {
+                s.push(node->right_);
+            }
+            unlinked_.push_back(node);
+        }
+        publish(nullptr);
+    } catch (...) {
+        abandon();
+        throw;
+    }
+}
+
+template<typename T, typename Interval>
+Interval ConcurrentIntervalTree<T, Interval>::search(const Interval& key) const {
+    EpochDomain::Guard guard(domain_);
+    NodePtr found = root_.load();
+    while (found != nullptr && found->key() != key) {
+        if (key < found->key()) {
+            found = found->left();
+        } else {
+            found = found->right();
+        }
+    }
+    return found == nullptr ? nil() : found->key();
+}
+
+template<typename T, typename Interval>
+Interval ConcurrentIntervalTree<T, Interval>::search(unsigned long offset) const {
+    EpochDomain::Guard guard(domain_);
+    NodePtr found = root_.load();
+    while (found != nullptr && static_cast<unsigned long>(found->key().start()) != offset) {
+        if (offset < static_cast<unsigned long>(found->key().start())) {
+            found = found->left();
+        } else {
+            found = found->right();
+        }
+    }
+    return found == nullptr ? nil() : found->key();
+}
+
+template<typename T, typename Interval>
+void ConcurrentIntervalTree<T, Interval>::overlapSearch(const NodePtr _root_, const Interval& i, std::set<Interval>& res) {
+    NodePtr curr = _root_;
+    if (curr == nullptr) {
+        return;
+    }
+    std::stack<NodePtr> s;
+    s.push(curr);
+    while (!s.empty()) {
+        curr = s.top();
+        s.pop();
+        if (overlap(curr->key(), i)) {
+            res.insert(curr->key());
+        }
+        /**
+         *          | max
+         *  start |----------| end
+         */
+        if (curr->left() != nullptr && curr->left()->max() > i.start()) {
+            s.push(curr->left());
+        }
+        /**
+         *                  | min
+         *  start |------------| end
+         */
+        if (curr->right() != nullptr && curr->right()->min() < i.end()) {
+            s.push(curr->right());
+        }
+    }
+}
+
+#endif // CONCURRENT_INTERVAL_TREE_CPP
@@ -0,0 +1,353 @@
+/*
+ * ConcurrentIntervalTree.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: andrei
+ */
+
+#ifndef CONCURRENTINTERVALTREE_HPP_
+#define CONCURRENTINTERVALTREE_HPP_
+
+#include <iostream>
+#include <algorithm>
+#include <set>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <utility>
+
+#include <Interval.hpp>
+
+/**
+ * Epoch based reclamation.
+ *
+ * A reader announces the global epoch in a free slot before it touches shared nodes
+ * and releases the slot when it is done. A node unlinked by the writer is tagged with
+ * the epoch current at the moment of unlinking; it can be freed once every announced
+ * epoch is newer than the tag, because such readers started after the node became
+ * unreachable.
+ *
+ * see also "Practical lock-freedom", Keir Fraser, 2004.
+ */
+class EpochDomain {
+public:
+    /**
+     * number of readers that can be inside the domain at the same time.
+     * Further readers spin until a slot is released.
+     */
+    static const std::size_t SLOTS = 128;
+
+private:
+    /**
+     * 0 - slot is free, otherwise the epoch announced by the reader.
+     * Padded to a cache line so readers do not share lines.
+     */
+    struct Slot {
+        std::atomic<unsigned long long> epoch;
+        char pad[64 - sizeof(std::atomic<unsigned long long>)];
+    };
+
+    std::atomic<unsigned long long> epoch_;
+    Slot slots_[SLOTS];
+
+public:
+    EpochDomain() : epoch_(1ULL) {
+        for (std::size_t i = 0; i < SLOTS; ++i) {
+            slots_[i].epoch.store(0ULL, std::memory_order_relaxed);
+        }
+    }
+
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    /**
+     * announce the current epoch, returns the slot to pass to exit().
+     */
+    std::size_t enter() {
+        std::size_t i = std::hash<std::thread::id>()(std::this_thread::get_id()) % SLOTS;
+        for (;;) {
+            unsigned long long expected = 0ULL;
+            if (slots_[i].epoch.compare_exchange_strong(expected, epoch_.load())) {
+                return i;
+            }
+            i = (i + 1) % SLOTS;
+        }
+    }
+
+    void exit(std::size_t slot) {
+        slots_[slot].epoch.store(0ULL, std::memory_order_release);
+    }
+
+    unsigned long long epoch() const {
+        return epoch_.load();
+    }
+
+    /**
+     * called by the writer after unlinked nodes have been tagged with epoch().
+     */
+    void advance() {
+        epoch_.fetch_add(1ULL);
+    }
+
+    /**
+     * the oldest epoch announced by an active reader,
+     * or the current epoch if there are no readers.
+     */
+    unsigned long long oldest() const {
+        unsigned long long oldest = epoch_.load();
+        for (std::size_t i = 0; i < SLOTS; ++i) {
+            unsigned long long e = slots_[i].epoch.load();
+            if (e != 0ULL && e < oldest) {
+                oldest = e;
+            }
+        }
+        return oldest;
+    }
+
+    /**
+     * RAII reader section.
+     */
+    class Guard {
+    private:
+        EpochDomain& domain_;
+        std::size_t slot_;
+    public:
+        explicit Guard(EpochDomain& domain) : domain_(domain), slot_(domain.enter()) {}
+        ~Guard() {
+            domain_.exit(slot_);
+        }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+};
+
+/**
+ * Interval tree for read-mostly workloads shared between threads.
+ *
+ * Readers (search, overlapSearch) never lock: they load the root and walk immutable nodes.
+ * Writers (insert, remove, clear) are serialized by a mutex. A writer never changes a
+ * published node, it copies the nodes on the path from the modified node up to the root,
+ * publishes the new root with one atomic store and retires the replaced nodes to the
+ * EpochDomain.
+ *
+ * Copied paths are rebalanced by height (AVL). Red-black fix-ups walk up through parent
+ * pointers, which path copying cannot maintain; AVL rebalancing only touches nodes on
+ * the copied path and their direct children.
+ *
+ * Queries return intervals by value, a reference into a node would not survive the
+ * reclamation of the node.
+ */
+template<typename T, typename Interval = IntervalT<T>>
+class ConcurrentIntervalTree {
+private:
+
+    /**
+     * type that represents a node in the tree.
+     * The node is immutable once it is reachable from the published root.
+     */
+    class OrdinaryNode {
+    private:
+        OrdinaryNode *left_;
+        OrdinaryNode *right_;
+        Interval key_;
+        int height_;
+        /**
+         * Node is augmented with maximal right endpoint in subtree rooted in x.
+         */
+        unsigned long max_;
+        /**
+         * Node is augmented with minimal left endpoint in subtree rooted in x.
+         */
+        unsigned long min_;
+        /**
+         * Write operation that created the node.
+         * The node is private to the writer while it is equal to the current one.
+         */
+        unsigned long generation_;
+    public:
+        OrdinaryNode(const Interval& key, unsigned long generation) :
+                left_(nullptr), right_(nullptr), key_(key), height_(1),
+                max_(key.end()), min_(key.start()), generation_(generation) {}
+
+        OrdinaryNode(const OrdinaryNode& node, unsigned long generation) :
+                left_(node.left_), right_(node.right_), key_(node.key_), height_(node.height_),
+                max_(node.max_), min_(node.min_), generation_(generation) {}
+
+        OrdinaryNode* left() const {
+            return left_;
+        }
+        OrdinaryNode* right() const {
+            return right_;
+        }
+        const Interval& key() const {
+            return key_;
+        }
+        unsigned long max() const {
+            return max_;
+        }
+        unsigned long min() const {
+            return min_;
+        }
+        friend class ConcurrentIntervalTree;
+    };
+
+    typedef OrdinaryNode* NodePtr;
+
+    std::atomic<NodePtr> root_;
+
+    /**
+     * serializes writers.
+     */
+    std::mutex writer_;
+
+    mutable EpochDomain domain_;
+
+    /**
+     * incremented by each write operation.
+     */
+    unsigned long generation_;
+
+    /**
+     * published nodes replaced by the current write operation.
+     */
+    std::vector<NodePtr> unlinked_;
+
+    /**
+     * nodes allocated by the current write operation.
+     */
+    std::vector<NodePtr> created_;
+
+    /**
+     * nodes allocated and dropped again by the current write operation,
+     * freed once the write succeeds.
+     */
+    std::vector<NodePtr> discarded_;
+
+    /**
+     * unlinked nodes with the epoch they were retired in.
+     */
+    std::vector<std::pair<NodePtr, unsigned long long>> retired_;
+
+    static const Interval& nil() {
+        static const Interval invalid;
+        return invalid;
+    }
+
+    static int height(NodePtr node) {
+        return node == nullptr ? 0 : node->height_;
+    }
+
+    /**
+     * recalculate height and augmentation of the writable node.
+     */
+    static void update(NodePtr node);
+
+    /**
+     * returns the node itself if it is private to the current write operation,
+     * otherwise its copy. The original is unlinked.
+     */
+    NodePtr writable(NodePtr node);
+
+    /**
+     * the node is not a part of the new version of the tree.
+     */
+    void discard(NodePtr node);
+
+    /**
+     * new node of the current generation, from an interval or a copy of a node.
+     */
+    template<typename Source>
+    NodePtr allocate(const Source& source);
+
+    /**
+     * undo a failed write: free its nodes, the published version stays as it was.
+     */
+    void abandon();
+
+    NodePtr rotateLeft(NodePtr x);
+    NodePtr rotateRight(NodePtr x);
+
+    /**
+     * restore AVL balance at the writable node.
+     */
+    NodePtr balance(NodePtr node);
+
+    NodePtr insert(NodePtr node, const Interval& key);
+    NodePtr remove(NodePtr node, const Interval& key);
+
+    /**
+     * detach the node with the minimum key from the subtree.
+     */
+    NodePtr removeMinimum(NodePtr node, NodePtr& minimum);
+
+    /**
+     * make the new version visible to readers and reclaim what readers no longer see.
+     */
+    void publish(NodePtr root);
+
+    void reclaim();
+
+    /**
+     * free the subtree, used when there are no readers.
+     */
+    static void destroy(NodePtr node);
+
+    static void overlapSearch(const NodePtr _root_, const Interval& i, std::set<Interval>& res);
+
+public:
+
+    ConcurrentIntervalTree() : root_(nullptr), generation_(0UL) {}
+
+    ConcurrentIntervalTree(const ConcurrentIntervalTree&) = delete;
+    ConcurrentIntervalTree& operator=(const ConcurrentIntervalTree&) = delete;
+
+    /**
+     * there must be no readers at this point.
+     */
+    ~ConcurrentIntervalTree();
+
+    bool empty() const {
+        return root_.load() == nullptr;
+    }
+
+    /**
+     * search the tree for the key k and return the copy of the corresponding Interval.
+     * Return valid interval if found and not valid otherwise.
+     * Lock free.
+     */
+    Interval search(const Interval& k) const;
+
+    /**
+     * Search the tree for the interval with given offset.
+     * Return valid interval if found and not valid otherwise.
+     * Lock free.
+     */
+    Interval search(unsigned long offset) const;
+
+    /**
+     * Finds in the tree intervals overlapping with the given.
+     * Lock free, the result reflects one version of the tree.
+     */
+    void overlapSearch(const Interval& i, std::set<Interval>& res) const {
+        EpochDomain::Guard guard(domain_);
+        overlapSearch(root_.load(), i, res);
+    }
+
+    /**
+     * insert the key to the tree, readers see the change after return.
+     */
+    bool insert(const Interval& key);
+
+    /**
+     * delete the key from the tree, readers see the change after return.
+     */
+    bool remove(const Interval& key);
+
+    void clear();
+};
+
+#include "ConcurrentIntervalTree.cpp"
+
+#endif /* CONCURRENTINTERVALTREE_HPP_ */
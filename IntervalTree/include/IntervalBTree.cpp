@@ -0,0 +1,366 @@
+#ifndef INTERVAL_BTREE_CPP
+#define INTERVAL_BTREE_CPP
+
+template<typename T, typename Interval, unsigned Order>
+void IntervalBTree<T, Interval, Order>::destroy(NodePtr node) {
+    if (node == nullptr) {
+        return;
+    }
+    if (node->leaf) {
+        delete leaf(node);
+        return;
+    }
+    Inner* n = inner(node);
+    for (unsigned i = 0; i < n->count; ++i) {
+        destroy(n->children[i]);
+    }
+    delete n;
+}
+
+/**
+ * The separators are sorted, the child is the last one with minStart <= start.
+ * Unused slots hold the greatest value, the whole array is scanned without branches.
+ */
+template<typename T, typename Interval, unsigned Order>
+unsigned IntervalBTree<T, Interval, Order>::childFor(const Inner* node, T start) {
+    unsigned child = 0;
+    for (unsigned i = 1; i < Order; ++i) {
+        child += node->minStart[i] <= start ? 1U : 0U;
+    }
+    return std::min(child, node->count - 1);
+}
+
+template<typename T, typename Interval, unsigned Order>
+unsigned IntervalBTree<T, Interval, Order>::lowerBound(const Leaf* node, T start) {
+    unsigned pos = 0;
+    for (unsigned i = 0; i < Order; ++i) {
+        pos += node->starts[i] < start ? 1U : 0U;
+    }
+    return pos;
+}
+
+template<typename T, typename Interval, unsigned Order>
+T IntervalBTree<T, Interval, Order>::minStart(const NodePtr node) {
+    return node->leaf ? leaf(node)->starts[0] : inner(node)->minStart[0];
+}
+
+template<typename T, typename Interval, unsigned Order>
+T IntervalBTree<T, Interval, Order>::maxEnd(const NodePtr node) {
+    const T* ends = node->leaf ? leaf(node)->ends : inner(node)->maxEnd;
+    T result = padEnd();
+    for (unsigned i = 0; i < Order; ++i) {
+        result = ends[i] > result ? ends[i] : result;
+    }
+    return result;
+}
+
+template<typename T, typename Interval, unsigned Order>
+void IntervalBTree<T, Interval, Order>::refresh(Inner* node, unsigned i) {
+    node->minStart[i] = minStart(node->children[i]);
+    node->maxEnd[i] = maxEnd(node->children[i]);
+}
+
+template<typename T, typename Interval, unsigned Order>
+void IntervalBTree<T, Interval, Order>::moveEntries(Leaf* dst, unsigned to, const Leaf* src, unsigned from, unsigned n) {
+    if (dst == src && to > from) {
+        std::copy_backward(src->starts + from, src->starts + from + n, dst->starts + to + n);
+        std::copy_backward(src->ends + from, src->ends + from + n, dst->ends + to + n);
+        std::copy_backward(src->keys + from, src->keys + from + n, dst->keys + to + n);
+    } else {
+        std::copy(src->starts + from, src->starts + from + n, dst->starts + to);
+        std::copy(src->ends + from, src->ends + from + n, dst->ends + to);
+        std::copy(src->keys + from, src->keys + from + n, dst->keys + to);
+    }
+}
+
+template<typename T, typename Interval, unsigned Order>
+void IntervalBTree<T, Interval, Order>::moveEntries(Inner* dst, unsigned to, const Inner* src, unsigned from, unsigned n) {
+    if (dst == src && to > from) {
+        std::copy_backward(src->minStart + from, src->minStart + from + n, dst->minStart + to + n);
+        std::copy_backward(src->maxEnd + from, src->maxEnd + from + n, dst->maxEnd + to + n);
+        std::copy_backward(src->children + from, src->children + from + n, dst->children + to + n);
+    } else {
+        std::copy(src->minStart + from, src->minStart + from + n, dst->minStart + to);
+        std::copy(src->maxEnd + from, src->maxEnd + from + n, dst->maxEnd + to);
+        std::copy(src->children + from, src->children + from + n, dst->children + to);
+    }
+}
+
+template<typename T, typename Interval, unsigned Order>
+void IntervalBTree<T, Interval, Order>::clearTail(Leaf* node) {
+    std::fill(node->starts + node->count, node->starts + Order, padStart());
+    std::fill(node->ends + node->count, node->ends + Order, padEnd());
+    std::fill(node->keys + node->count, node->keys + Order, Interval());
+}
+
+template<typename T, typename Interval, unsigned Order>
+void IntervalBTree<T, Interval, Order>::clearTail(Inner* node) {
+    std::fill(node->minStart + node->count, node->minStart + Order, padStart());
+    std::fill(node->maxEnd + node->count, node->maxEnd + Order, padEnd());
+    std::fill(node->children + node->count, node->children + Order, static_cast<Node*>(nullptr));
+}
+
+template<typename T, typename Interval, unsigned Order>
+typename IntervalBTree<T, Interval, Order>::NodePtr IntervalBTree<T, Interval, Order>::insert(NodePtr node, const Interval& key, bool& inserted) {
+    if (node->leaf) {
+        Leaf* l = leaf(node);
+        unsigned pos = lowerBound(l, key.start());
+        if (pos < l->count && l->starts[pos] == key.start()) {
+            inserted = false;
+            return nullptr;
+        }
+        inserted = true;
+        Leaf* target = l;
+        Leaf* sibling = nullptr;
+        if (l->count == Order) {
+            sibling = split(l);
+            if (pos > l->count) {
+                target = sibling;
+                pos -= l->count;
+            }
+        }
+        openSlot(target, pos);
+        target->starts[pos] = key.start();
+        target->ends[pos] = key.end();
+        target->keys[pos] = key;
+        return sibling;
+    }
+
+    Inner* n = inner(node);
+    unsigned c = childFor(n, key.start());
+    NodePtr child = insert(n->children[c], key, inserted);
+    if (!inserted) {
+        return nullptr;
+    }
+    refresh(n, c);
+    if (child == nullptr) {
+        return nullptr;
+    }
+    /*
+     * the child was split, its new right sibling goes next to it.
+     */
+    unsigned pos = c + 1;
+    Inner* target = n;
+    Inner* sibling = nullptr;
+    if (n->count == Order) {
+        sibling = split(n);
+        if (pos > n->count) {
+            target = sibling;
+            pos -= n->count;
+        }
+    }
+    openSlot(target, pos);
+    target->children[pos] = child;
+    refresh(target, pos);
+    return sibling;
+}
+
+template<typename T, typename Interval, unsigned Order>
+bool IntervalBTree<T, Interval, Order>::insert(const Interval& key) {
+    if (root_ == nullptr) {
+        root_ = new Leaf();
+    }
+    bool inserted = false;
+    NodePtr sibling = insert(root_, key, inserted);
+    if (sibling != nullptr) {
+        Inner* root = new Inner();
+        root->count = 2;
+        root->children[0] = root_;
+        root->children[1] = sibling;
+        refresh(root, 0);
+        refresh(root, 1);
+        root_ = root;
+    }
+    return inserted;
+}
+
+/**
+ * Two neighbours together hold more than Order/2 entries, so the result is either
+ * one node that fits or two nodes at least half full.
+ */
+template<typename T, typename Interval, unsigned Order>
+template<typename NodeType>
+bool IntervalBTree<T, Interval, Order>::rebalance(NodeType* left, NodeType* right) {
+    unsigned total = left->count + right->count;
+    if (total <= Order) {
+        moveEntries(left, left->count, right, 0, right->count);
+        left->count = total;
+        right->count = 0;
+        return true;
+    }
+    unsigned half = total / 2;
+    if (left->count < half) {
+        unsigned k = half - left->count;
+        moveEntries(left, left->count, right, 0, k);
+        left->count += k;
+        moveEntries(right, 0, right, k, right->count - k);
+        right->count -= k;
+        clearTail(right);
+    } else {
+        unsigned k = left->count - half;
+        moveEntries(right, k, right, 0, right->count);
+        moveEntries(right, 0, left, left->count - k, k);
+        right->count += k;
+        left->count -= k;
+        clearTail(left);
+    }
+    return false;
+}
+
+template<typename T, typename Interval, unsigned Order>
+void IntervalBTree<T, Interval, Order>::rebalance(Inner* node, unsigned i) {
+    unsigned a = i + 1 < node->count ? i : i - 1;
+    unsigned b = a + 1;
+    bool merged = node->children[a]->leaf
+            ? rebalance(leaf(node->children[a]), leaf(node->children[b]))
+            : rebalance(inner(node->children[a]), inner(node->children[b]));
+    if (merged) {
+        destroy(node->children[b]);
+        moveEntries(node, b, node, b + 1, node->count - b - 1);
+        --node->count;
+        clearTail(node);
+    } else {
+        refresh(node, b);
+    }
+    refresh(node, a);
+}
+
+template<typename T, typename Interval, unsigned Order>
+bool IntervalBTree<T, Interval, Order>::remove(NodePtr node, const Interval& key) {
+    if (node->leaf) {
+        Leaf* l = leaf(node);
+        unsigned pos = lowerBound(l, key.start());
+        if (pos == l->count || l->starts[pos] != key.start()) {
+            return false;
+        }
+        moveEntries(l, pos, l, pos + 1, l->count - pos - 1);
+        --l->count;
+        clearTail(l);
+        return true;
+    }
+
+    Inner* n = inner(node);
+    unsigned c = childFor(n, key.start());
+    if (!remove(n->children[c], key)) {
+        return false;
+    }
+    if (n->children[c]->count < Order / 2 && n->count > 1) {
+        rebalance(n, c);
+    } else {
+        refresh(n, c);
+    }
+    return true;
+}
+
+template<typename T, typename Interval, unsigned Order>
+bool IntervalBTree<T, Interval, Order>::remove(const Interval& key) {
+    if (root_ == nullptr || !remove(root_, key)) {
+        return false;
+    }
+    if (root_->count == 0) {
+        destroy(root_);
+        root_ = nullptr;
+    } else if (!root_->leaf && root_->count == 1) {
+        Inner* root = inner(root_);
+        root_ = root->children[0];
+        delete root;
+    }
+    return true;
+}
+
+template<typename T, typename Interval, unsigned Order>
+const Interval& IntervalBTree<T, Interval, Order>::search(const NodePtr node, T start) {
+    if (node == nullptr) {
+        return nil();
+    }
+    NodePtr found = node;
+    while (!found->leaf) {
+        found = inner(found)->children[childFor(inner(found), start)];
+    }
+    const Leaf* l = leaf(found);
+    unsigned pos = lowerBound(l, start);
+    if (pos < l->count && l->starts[pos] == start) {
+        return l->keys[pos];
+    }
+    return nil();
+}
+
+/**
+ * The overlap test is evaluated for all slots of the node first, then the hits are visited.
+ *
+ *          | maxEnd
+ *  start |----------| end
+ *                  | minStart
+ */
+template<typename T, typename Interval, unsigned Order>
+void IntervalBTree<T, Interval, Order>::overlapSearch(const NodePtr node, const Interval& i, std::set<Interval>& res) {
+    const T start = i.start();
+    const T end = i.end();
+    const T* starts = node->leaf ? leaf(node)->starts : inner(node)->minStart;
+    const T* ends = node->leaf ? leaf(node)->ends : inner(node)->maxEnd;
+    bool hits[Order];
+    for (unsigned k = 0; k < Order; ++k) {
+        hits[k] = (starts[k] < end) & (ends[k] > start);
+    }
+    for (unsigned k = 0; k < node->count; ++k) {
+        if (!hits[k]) {
+            continue;
+        }
+        if (node->leaf) {
+            res.insert(leaf(node)->keys[k]);
+        } else {
+            overlapSearch(inner(node)->children[k], i, res);
+        }
+    }
+}
+
+template<typename T, typename Interval, unsigned Order>
+int IntervalBTree<T, Interval, Order>::depth(const NodePtr node, bool root) {
+    if (node->count == 0 || node->count > Order || (!root && node->count < Order / 2)) {
+        return -1;
+    }
+    if (node->leaf) {
+        const Leaf* l = leaf(node);
+        for (unsigned k = 0; k < Order; ++k) {
+            if (k < l->count) {
+                if (l->starts[k] != l->keys[k].start() || l->ends[k] != l->keys[k].end()
+                        || (k > 0 && !(l->starts[k - 1] < l->starts[k]))) {
+                    return -1;
+                }
+            } else if (l->starts[k] != padStart() || l->ends[k] != padEnd()) {
+                return -1;
+            }
+        }
+        return 0;
+    }
+    const Inner* n = inner(node);
+    int d = -1;
+    for (unsigned k = 0; k < n->count; ++k) {
+        int child = depth(n->children[k], false);
+        if (child < 0 || (d >= 0 && child != d)
+                || n->minStart[k] != minStart(n->children[k]) || n->maxEnd[k] != maxEnd(n->children[k])) {
+            return -1;
+        }
+        /*
+         * the last start of the child is below the separator of the next one.
+         */
+        if (k + 1 < n->count) {
+            NodePtr last = n->children[k];
+            while (!last->leaf) {
+                last = inner(last)->children[last->count - 1];
+            }
+            if (!(leaf(last)->starts[last->count - 1] < n->minStart[k + 1])) {
+                return -1;
+            }
+        }
+        d = child;
+    }
+    for (unsigned k = n->count; k < Order; ++k) {
+        if (n->minStart[k] != padStart() || n->maxEnd[k] != padEnd() || n->children[k] != nullptr) {
+            return -1;
+        }
+    }
+    return d + 1;
+}
+
+#endif // INTERVAL_BTREE_CPP
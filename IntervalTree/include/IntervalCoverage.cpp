@@ -0,0 +1,238 @@
+#ifndef INTERVAL_COVERAGE_CPP
+#define INTERVAL_COVERAGE_CPP
+
+template<typename T, typename Interval>
+void IntervalCoverage<T, Interval>::destroy(Node* node) {
+    while (node != nullptr) {
+        destroy(node->left);
+        Node* right = node->right;
+        delete node;
+        node = right;
+    }
+}
+
+template<typename T, typename Interval>
+void IntervalCoverage<T, Interval>::addGaps(Summary& s, long depth, T length) {
+    if (s.minLength == T() || depth < s.minDepth) {
+        s.minDepth = depth;
+        s.minLength = length;
+    } else if (depth == s.minDepth) {
+        s.minLength += length;
+    }
+}
+
+/**
+ * The gaps of y and the gap between x and y lie after all endpoints of x,
+ * their depth grows by the sum of x.
+ */
+template<typename T, typename Interval>
+typename IntervalCoverage<T, Interval>::Summary IntervalCoverage<T, Interval>::combine(const Summary& x, const Summary& y) {
+    if (x.empty) {
+        return y;
+    }
+    if (y.empty) {
+        return x;
+    }
+    Summary s = x;
+    s.last = y.last;
+    s.sum = x.sum + y.sum;
+    addGaps(s, x.sum, y.first - x.last);
+    if (y.minLength != T()) {
+        addGaps(s, x.sum + y.minDepth, y.minLength);
+    }
+    if (x.sum + y.maxDepth > x.maxDepth) {
+        s.maxDepth = x.sum + y.maxDepth;
+        s.maxAt = y.maxAt;
+    }
+    return s;
+}
+
+template<typename T, typename Interval>
+void IntervalCoverage<T, Interval>::update(Node* node) {
+    node->summary = combine(combine(summary(node->left), summary(node->point, node->delta)), summary(node->right));
+}
+
+template<typename T, typename Interval>
+typename IntervalCoverage<T, Interval>::Node* IntervalCoverage<T, Interval>::rotateLeft(Node* x) {
+    Node* y = x->right;
+    x->right = y->left;
+    y->left = x;
+    update(x);
+    update(y);
+    return y;
+}
+
+template<typename T, typename Interval>
+typename IntervalCoverage<T, Interval>::Node* IntervalCoverage<T, Interval>::rotateRight(Node* x) {
+    Node* y = x->left;
+    x->left = y->right;
+    y->right = x;
+    update(x);
+    update(y);
+    return y;
+}
+
+template<typename T, typename Interval>
+typename IntervalCoverage<T, Interval>::Node* IntervalCoverage<T, Interval>::insert(Node* node, T point, long delta) {
+    if (node == nullptr) {
+        node = new Node(point, nextPriority());
+        node->delta = delta;
+        node->count = 1UL;
+        update(node);
+        return node;
+    }
+    if (point < node->point) {
+        node->left = insert(node->left, point, delta);
+        if (node->left->priority > node->priority) {
+            return rotateRight(node);
+        }
+    } else if (node->point < point) {
+        node->right = insert(node->right, point, delta);
+        if (node->right->priority > node->priority) {
+            return rotateLeft(node);
+        }
+    } else {
+        node->delta += delta;
+        ++node->count;
+    }
+    update(node);
+    return node;
+}
+
+template<typename T, typename Interval>
+typename IntervalCoverage<T, Interval>::Node* IntervalCoverage<T, Interval>::remove(Node* node, T point, long delta) {
+    if (point < node->point) {
+        node->left = remove(node->left, point, delta);
+    } else if (node->point < point) {
+        node->right = remove(node->right, point, delta);
+    } else {
+        node->delta -= delta;
+        if (--node->count == 0UL) {
+            Node* merged = merge(node->left, node->right);
+            delete node;
+            return merged;
+        }
+    }
+    update(node);
+    return node;
+}
+
+template<typename T, typename Interval>
+typename IntervalCoverage<T, Interval>::Node* IntervalCoverage<T, Interval>::merge(Node* a, Node* b) {
+    if (a == nullptr) {
+        return b;
+    }
+    if (b == nullptr) {
+        return a;
+    }
+    if (a->priority > b->priority) {
+        a->right = merge(a->right, b);
+        update(a);
+        return a;
+    }
+    b->left = merge(a, b->left);
+    update(b);
+    return b;
+}
+
+/**
+ * A subtree entirely inside (a, b) gives its summary. Below the node where the
+ * paths to a and b part, one side of every node on the paths is entirely inside,
+ * so O(height) nodes are visited.
+ */
+template<typename T, typename Interval>
+typename IntervalCoverage<T, Interval>::Summary IntervalCoverage<T, Interval>::fold(const Node* node, T a, T b) {
+    if (node == nullptr) {
+        return Summary();
+    }
+    if (a < node->summary.first && node->summary.last < b) {
+        return node->summary;
+    }
+    if (!(a < node->point)) {
+        return fold(node->right, a, b);
+    }
+    if (!(node->point < b)) {
+        return fold(node->left, a, b);
+    }
+    return combine(combine(fold(node->left, a, b), summary(node->point, node->delta)), fold(node->right, a, b));
+}
+
+template<typename T, typename Interval>
+bool IntervalCoverage<T, Interval>::remove(const Interval& i) {
+    if (!(i.start() < i.end())) {
+        return false;
+    }
+    typename std::multiset<std::pair<T, T>>::iterator found = intervals_.find(std::make_pair(i.start(), i.end()));
+    if (found == intervals_.end()) {
+        return false;
+    }
+    intervals_.erase(found);
+    root_ = remove(root_, i.start(), 1L);
+    root_ = remove(root_, i.end(), -1L);
+    return true;
+}
+
+template<typename T, typename Interval>
+long IntervalCoverage<T, Interval>::depth(T point) const {
+    long sum = 0L;
+    for (const Node* node = root_; node != nullptr;) {
+        if (point < node->point) {
+            node = node->left;
+        } else {
+            sum += summary(node->left).sum + node->delta;
+            node = node->right;
+        }
+    }
+    return sum;
+}
+
+/**
+ * The window is cut by the endpoints inside it: the piece before the first one
+ * has the depth at the window start, the gaps between them are summarized by fold,
+ * the piece after the last one has the depth after all of them.
+ */
+template<typename T, typename Interval>
+T IntervalCoverage<T, Interval>::coveredLength(const Interval& window) const {
+    T a = window.start(), b = window.end();
+    if (!(a < b)) {
+        return T();
+    }
+    long before = depth(a);
+    Summary inside = fold(root_, a, b);
+    if (inside.empty) {
+        return before > 0L ? b - a : T();
+    }
+    T covered = inside.last - inside.first;
+    if (inside.minLength != T() && before + inside.minDepth == 0L) {
+        covered -= inside.minLength;
+    }
+    if (before > 0L) {
+        covered += inside.first - a;
+    }
+    if (before + inside.sum > 0L) {
+        covered += b - inside.last;
+    }
+    return covered;
+}
+
+/**
+ * The depth changes only at the endpoints: the peak is at the window start or right
+ * after an endpoint inside the window.
+ */
+template<typename T, typename Interval>
+long IntervalCoverage<T, Interval>::maxDepth(const Interval& window, T& at) const {
+    T a = window.start(), b = window.end();
+    at = a;
+    if (!(a < b)) {
+        return 0L;
+    }
+    long before = depth(a);
+    Summary inside = fold(root_, a, b);
+    if (!inside.empty && before + inside.maxDepth > before) {
+        at = inside.maxAt;
+        return before + inside.maxDepth;
+    }
+    return before;
+}
+
+#endif /* INTERVAL_COVERAGE_CPP */
@@ -0,0 +1,237 @@
+/*
+ * IntervalCoverage.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: andrei
+ */
+
+#ifndef INTERVALCOVERAGE_HPP_
+#define INTERVALCOVERAGE_HPP_
+
+#include <iostream>
+#include <algorithm>
+#include <set>
+#include <utility>
+
+#include <Interval.hpp>
+
+/**
+ * Index of the points covered by a multiset of intervals: how much of a window is
+ * covered by at least one interval and how many intervals are active at most at once
+ * in it, without visiting the intervals overlapping it.
+ * Kept alongside IntervalTree, an interval is inserted into (removed from) both.
+ *
+ * A node is a distinct endpoint with delta = number of starts - number of ends there,
+ * the depth at x (the number of intervals containing x) is the sum of the deltas of the
+ * endpoints <= x. A subtree is summarized over the gaps between its consecutive
+ * endpoints: the minimal depth relative to the subtree start and the total length of
+ * the gaps with that depth. Depth is never negative, so the gaps at depth 0 are the
+ * uncovered ones - the summary of the min and the count of the min of segment trees,
+ * over endpoints added and removed at run time. The maximal depth right after an
+ * endpoint of the subtree, again relative to the subtree start, gives the peak.
+ *
+ * Balanced as a treap: a random priority per node, a parent has a higher priority than
+ * its children. O(log n) expected for insert, remove and queries.
+ *
+ * see also "Randomized search trees", R. Seidel, C. R. Aragon, 1996.
+ */
+template<typename T, typename Interval = IntervalT<T>>
+class IntervalCoverage {
+private:
+    /**
+     * summary of consecutive endpoints [first, last].
+     */
+    struct Summary {
+        bool empty;
+        T first;
+        T last;
+        /**
+         * sum of deltas.
+         */
+        long sum;
+        /**
+         * the minimal depth over the gaps relative to the depth before first,
+         * and the total length of the gaps at it. minLength is 0 if there are no gaps,
+         * the endpoints are distinct so every gap has positive length.
+         */
+        long minDepth;
+        T minLength;
+        /**
+         * the maximal depth right after an endpoint relative to the depth before first,
+         * maxAt - the first endpoint with it.
+         */
+        long maxDepth;
+        T maxAt;
+
+        Summary() : empty(true), first(), last(), sum(0L), minDepth(0L), minLength(), maxDepth(0L), maxAt() {}
+    };
+
+    struct Node {
+        T point;
+        long delta;
+        /**
+         * endpoints of the intervals at the point, the node goes with the last one.
+         */
+        unsigned long count;
+        unsigned long priority;
+        Node* left;
+        Node* right;
+        Summary summary;
+
+        Node(T p, unsigned long prio) : point(p), delta(0L), count(0UL), priority(prio), left(nullptr), right(nullptr) {}
+    };
+
+    Node* root_;
+    /**
+     * the inserted intervals as (start, end), so remove takes away only one of them.
+     */
+    std::multiset<std::pair<T, T>> intervals_;
+    /**
+     * xorshift state of the priorities.
+     */
+    unsigned long seed_;
+
+    unsigned long nextPriority() {
+        seed_ ^= seed_ << 13;
+        seed_ ^= seed_ >> 7;
+        seed_ ^= seed_ << 17;
+        return seed_;
+    }
+
+    static void destroy(Node* node);
+
+    static Summary summary(const Node* node) {
+        return node == nullptr ? Summary() : node->summary;
+    }
+
+    /**
+     * summary of the endpoint alone.
+     */
+    static Summary summary(T point, long delta) {
+        Summary s;
+        s.empty = false;
+        s.first = point;
+        s.last = point;
+        s.sum = delta;
+        s.maxDepth = delta;
+        s.maxAt = point;
+        return s;
+    }
+
+    /**
+     * count the gaps of given depth and length into s.
+     */
+    static void addGaps(Summary& s, long depth, T length);
+
+    /**
+     * summary of x followed by y.
+     */
+    static Summary combine(const Summary& x, const Summary& y);
+
+    static void update(Node* node);
+
+    static Node* rotateLeft(Node* x);
+    static Node* rotateRight(Node* x);
+
+    /**
+     * add delta at the point as one more endpoint, returns the new root of the subtree.
+     */
+    Node* insert(Node* node, T point, long delta);
+
+    /**
+     * take delta at the point away with one endpoint, the node goes with its last endpoint.
+     */
+    static Node* remove(Node* node, T point, long delta);
+
+    /**
+     * the subtrees a < b as one, by priorities.
+     */
+    static Node* merge(Node* a, Node* b);
+
+    /**
+     * summary of the endpoints x with a < x < b.
+     */
+    static Summary fold(const Node* node, T a, T b);
+
+public:
+    IntervalCoverage() : root_(nullptr), seed_(0x9E3779B97F4A7C15UL) {}
+
+    IntervalCoverage(const IntervalCoverage&) = delete;
+    IntervalCoverage& operator=(const IntervalCoverage&) = delete;
+
+    IntervalCoverage(IntervalCoverage&& other) noexcept : root_(other.root_), intervals_(std::move(other.intervals_)), seed_(other.seed_) {
+        other.root_ = nullptr;
+        other.intervals_.clear();
+    }
+
+    IntervalCoverage& operator=(IntervalCoverage&& other) noexcept {
+        if (this != &other) {
+            clear();
+            root_ = other.root_;
+            intervals_ = std::move(other.intervals_);
+            seed_ = other.seed_;
+            other.root_ = nullptr;
+            other.intervals_.clear();
+        }
+        return *this;
+    }
+
+    ~IntervalCoverage() {
+        destroy(root_);
+    }
+
+    bool empty() const {
+        return root_ == nullptr;
+    }
+
+    void clear() {
+        destroy(root_);
+        root_ = nullptr;
+        intervals_.clear();
+    }
+
+    /**
+     * Add the interval, the same interval can be added many times.
+     * Empty intervals cover nothing and are ignored.
+     */
+    void insert(const Interval& i) {
+        if (i.start() < i.end()) {
+            intervals_.insert(std::make_pair(i.start(), i.end()));
+            root_ = insert(root_, i.start(), 1L);
+            root_ = insert(root_, i.end(), -1L);
+        }
+    }
+
+    /**
+     * Take away one copy of an inserted interval.
+     * false (and nothing changes) if the interval is not indexed,
+     * which is always the case for an empty one.
+     */
+    bool remove(const Interval& i);
+
+    /**
+     * The number of intervals containing the point.
+     */
+    long depth(T point) const;
+
+    /**
+     * The length of the part of the window covered by at least one interval.
+     */
+    T coveredLength(const Interval& window) const;
+
+    /**
+     * The maximal number of intervals containing one point of the window (peak
+     * concurrency), at - the first point of the window with it.
+     * 0 and the window start for an empty window.
+     */
+    long maxDepth(const Interval& window, T& at) const;
+
+    long maxDepth(const Interval& window) const {
+        T at;
+        return maxDepth(window, at);
+    }
+};
+
+#include "IntervalCoverage.cpp"
+
+#endif /* INTERVALCOVERAGE_HPP_ */
@@ -4,11 +4,11 @@
 #include <iostream>
 #include <stack>
 
-template<typename T, typename Interval>
-typename IntervalTree<T, Interval>::OrdinaryNode IntervalTree<T, Interval>::nilNode;
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+typename IntervalTree<T, Interval, Allocator, Augment, Balance>::OrdinaryNode IntervalTree<T, Interval, Allocator, Augment, Balance>::nilNode;
 
-template<typename T, typename Interval>
-typename IntervalTree<T, Interval>::OrdinaryNode *const IntervalTree<T, Interval>::TNIL = &IntervalTree<T, Interval>::nilNode;
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+typename IntervalTree<T, Interval, Allocator, Augment, Balance>::OrdinaryNode *const IntervalTree<T, Interval, Allocator, Augment, Balance>::TNIL = &IntervalTree<T, Interval, Allocator, Augment, Balance>::nilNode;
 
 /**
  *  rotate left at node x
@@ -25,8 +25,8 @@ typename IntervalTree<T, Interval>::OrdinaryNode *const IntervalTree<T, Interval
  *     / \    / \
  *    b   c  a   b
  */
-template<typename T, typename Interval>
-void IntervalTree<T, Interval>::rotateLeft(NodePtr x) {
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::rotateLeft(NodePtr x) {
 
     NodePtr y = x->right();
 
@@ -62,12 +62,11 @@ void IntervalTree<T, Interval>::rotateLeft(NodePtr x) {
         x->parent(y);
 
     /**
-     * recalculate augmentation.
+     * recalculate augmentation: only x and y change their subtrees, the ancestors
+     * keep the same intervals, so their augmentation stays.
      */
-    for (NodePtr z = x; z != nullptr; z = z->parent()) {
-        z->max(max(z->key().end(), z->left(), z->right()));
-        z->min(min(z->key().start(), z->left(), z->right()));
-    }
+    refresh(x);
+    refresh(y);
 
 }
 
@@ -86,8 +85,8 @@ void IntervalTree<T, Interval>::rotateLeft(NodePtr x) {
  *   / \            / \
  *  a   b          b   c
  */
-template<typename T, typename Interval>
-void IntervalTree<T, Interval>::rotateRight(NodePtr x) {
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::rotateRight(NodePtr x) {
 
     NodePtr y = x->left();
 
@@ -125,17 +124,16 @@ void IntervalTree<T, Interval>::rotateRight(NodePtr x) {
     }
 
     /**
-     * recalculate augmentation.
+     * recalculate augmentation: only x and y change their subtrees, the ancestors
+     * keep the same intervals, so their augmentation stays.
      */
-    for (NodePtr z = x; z != nullptr; z = z->parent()) {
-        z->max(max(z->key().end(), z->left(), z->right()));
-        z->min(min(z->key().start(), z->left(), z->right()));
-    }
+    refresh(x);
+    refresh(y);
 
 }
 
-template<typename T, typename Interval>
-void IntervalTree<T, Interval>::fixInsert(NodePtr k) {
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+bool IntervalTree<T, Interval, Allocator, Augment, Balance>::fixInsert(NodePtr k) {
     NodePtr u(nullptr);
     while (k != root_ && k->parent()->color() == RED) {
         if (k->parent() == k->parent()->parent()->right()) { // k's parent is right child
@@ -179,11 +177,13 @@ void IntervalTree<T, Interval>::fixInsert(NodePtr k) {
             }
         }
     }
+    bool grown = root_->color() == RED;
     root_->color(BLACK);
+    return grown;
 }
 
-template<typename T, typename Interval>
-void IntervalTree<T, Interval>::fixDelete(NodePtr x) {
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::fixDelete(NodePtr x) {
     while (x != root_ && x->color() == BLACK) {
         if (x == x->parent()->left()) {
             NodePtr    w = x->parent()->right();
@@ -243,11 +243,179 @@ void IntervalTree<T, Interval>::fixDelete(NodePtr x) {
     }
 }
 
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+typename IntervalTree<T, Interval, Allocator, Augment, Balance>::NodePtr IntervalTree<T, Interval, Allocator, Augment, Balance>::rotateAvl(NodePtr z) {
+    if (z->left()->rank() > z->right()->rank()) {
+        NodePtr y = z->left();
+        if (y->right()->rank() > y->left()->rank()) {
+            rotateLeft(y);
+            setHeight(y);
+            setHeight(y->parent());
+        }
+        rotateRight(z);
+    } else {
+        NodePtr y = z->right();
+        if (y->left()->rank() > y->right()->rank()) {
+            rotateRight(y);
+            setHeight(y);
+            setHeight(y->parent());
+        }
+        rotateLeft(z);
+    }
+    setHeight(z);
+    setHeight(z->parent());
+    return z->parent();
+}
+
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::fixAvl(NodePtr z) {
+    while (z != nullptr) {
+        int height = z->rank();
+        int difference = z->left()->rank() - z->right()->rank();
+        if (difference > 1 || difference < -1) {
+            z = rotateAvl(z);
+        } else {
+            setHeight(z);
+        }
+        if (z->rank() == height) {
+            return;
+        }
+        z = z->parent();
+    }
+}
+
+/**
+ * Promote the parent while the sibling of x is a 1-child. Otherwise the sibling is
+ * a 2-child and one or two rotations end it: x is a 1,2 node, but for the middle node
+ * of join, which can be 1,1 and is promoted after the rotation, one level higher.
+ */
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::fixWavlInsert(NodePtr x) {
+    for (NodePtr p = x->parent(); p != nullptr && p->rank() == x->rank(); p = x->parent()) {
+        bool left = x == p->left();
+        NodePtr sibling = left ? p->right() : p->left();
+        if (p->rank() - sibling->rank() == 1) {
+            p->rank(p->rank() + 1);
+            x = p;
+            continue;
+        }
+        NodePtr inner = left ? x->right() : x->left();
+        NodePtr outer = left ? x->left() : x->right();
+        if (x->rank() - outer->rank() == 1) {
+            bool flat = x->rank() - inner->rank() == 1;
+            if (left) {
+                rotateRight(p);
+            } else {
+                rotateLeft(p);
+            }
+            if (!flat) {
+                p->rank(p->rank() - 1);
+                return;
+            }
+            x->rank(x->rank() + 1);
+            continue;
+        }
+        if (left) {
+            rotateLeft(x);
+            rotateRight(p);
+        } else {
+            rotateRight(x);
+            rotateLeft(p);
+        }
+        inner->rank(inner->rank() + 1);
+        x->rank(x->rank() - 1);
+        p->rank(p->rank() - 1);
+        return;
+    }
+}
+
+/**
+ * A 2,2 leaf is demoted first. Then, while x is a 3-child: demote the parent if the
+ * sibling is a 2-child, demote the parent and the sibling if the sibling is a 2,2 node,
+ * otherwise one or two rotations end it.
+ */
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::fixWavlDelete(NodePtr x, NodePtr p) {
+    if (p != nullptr && p->left() == TNIL && p->right() == TNIL && p->rank() == 2) {
+        p->rank(1);
+        x = p;
+        p = x->parent();
+    }
+    for (; p != nullptr && p->rank() - x->rank() == 3; p = x->parent()) {
+        bool left = x == p->left();
+        NodePtr sibling = left ? p->right() : p->left();
+        if (p->rank() - sibling->rank() == 2) {
+            p->rank(p->rank() - 1);
+            x = p;
+            continue;
+        }
+        NodePtr inner = left ? sibling->left() : sibling->right();
+        NodePtr outer = left ? sibling->right() : sibling->left();
+        if (sibling->rank() - inner->rank() == 2 && sibling->rank() - outer->rank() == 2) {
+            p->rank(p->rank() - 1);
+            sibling->rank(sibling->rank() - 1);
+            x = p;
+            continue;
+        }
+        if (sibling->rank() - outer->rank() == 1) {
+            if (left) {
+                rotateLeft(p);
+            } else {
+                rotateRight(p);
+            }
+            sibling->rank(sibling->rank() + 1);
+            p->rank(p->left() == TNIL && p->right() == TNIL ? 1 : p->rank() - 1);
+            return;
+        }
+        if (left) {
+            rotateRight(sibling);
+            rotateLeft(p);
+        } else {
+            rotateLeft(sibling);
+            rotateRight(p);
+        }
+        inner->rank(inner->rank() + 2);
+        sibling->rank(sibling->rank() - 1);
+        p->rank(p->rank() - 2);
+        return;
+    }
+}
+
+/**
+ * The new leaf gets a random priority and rotates up above the parents with lower ones.
+ */
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::rebalanceInsert(NodePtr node, TreapBalance) {
+    node->rank(nextPriority());
+    for (NodePtr p = node->parent(); p != nullptr && p->rank() < node->rank(); p = node->parent()) {
+        if (node == p->left()) {
+            rotateRight(p);
+        } else {
+            rotateLeft(p);
+        }
+    }
+}
+
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::siftDown(NodePtr node) {
+    for (;;) {
+        NodePtr child = node->left()->rank() > node->right()->rank() ? node->left() : node->right();
+        if (!(node->rank() < child->rank())) {
+            return;
+        }
+        if (child == node->left()) {
+            rotateRight(node);
+        } else {
+            rotateLeft(node);
+        }
+    }
+}
+
 /**
  * remove the key from the tree, starting at root.
  */
-template<typename T, typename Interval>
-bool IntervalTree<T, Interval>::remove(NodePtr root, const Interval &key) {
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+bool IntervalTree<T, Interval, Allocator, Augment, Balance>::remove(NodePtr root, const Interval &key) {
     /*
      * the cursor should point to the node to be deleted.
      */
@@ -266,91 +434,79 @@ bool IntervalTree<T, Interval>::remove(NodePtr root, const Interval &key) {
         return false;
     }
 
+    unlink(cursor);
+
+    /**
+     * delete node from memory.
+     */
+    destroyNode(cursor);
+    return true;
+}
+
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::unlink(NodePtr cursor) {
+    ++modifications_;
     /*
-     * y points to a node that will actually be removed from the tree. This will
+     * y points to a node that will actually leave its place in the tree. This will
      * be cursor if cursor has fewer than two children, or the minimum of the
      * right subtree of the cursor otherwise.
      */
-    NodePtr y(nullptr);
-
-    if (cursor->left() == TNIL || cursor->right() == TNIL) {
-        y = cursor;
-    } else {
-        y = cursor->right();
-        while (y->left() != TNIL) {
-            y = y->left();
-        }
-    }
+    NodePtr y = cursor;
+    int removed = y->rank();
 
     /*
-     * x points to a child of y.
+     * x points to the child that takes the place of y.
+     * x can be equal TNIL, its parent is still set for fixDelete.
      */
     NodePtr x(nullptr);
 
-    /**
-     * x can be equal TNIL if y->left() == TNIL && y->right() == TNIL.
-     */
-    if (y->left() != TNIL) {
-        x = y->left();
+    if (cursor->left() == TNIL) {
+        x = cursor->right();
+        rbTransplant(cursor, x);
+    } else if (cursor->right() == TNIL) {
+        x = cursor->left();
+        rbTransplant(cursor, x);
     } else {
+        y = minimum(cursor->right());
+        removed = y->rank();
         x = y->right();
-    }
-
-    /**
-     * remove y from the tree.
-     */
-    x->parent(y->parent());
-    if (y->parent() != nullptr) {
-        if (y == y->parent()->left()) {
-            y->parent()->left(x);
+        if (y->parent() == cursor) {
+            x->parent(y);
         } else {
-            y->parent()->right(x);
+            rbTransplant(y, x);
+            y->right(cursor->right());
+            y->right()->parent(y);
         }
-    } else {
-        root_ = x;
-    }
-
-    /*
-     * If we removed the tree successor of cursor rather than cursor itself, then move
-     * the data for the removed node to the one we were supposed to remove.
-     */
-    if (y != cursor) {
-        cursor->key(y->key());
+        /*
+         * the successor node itself replaces the cursor, so the key is neither
+         * copied nor moved.
+         */
+        rbTransplant(cursor, y);
+        y->left(cursor->left());
+        y->left()->parent(y);
+        y->rank(cursor->rank());
     }
 
     /**
      * recalculate augmentation.
      */
-    for (NodePtr z = y->parent(); z != nullptr; z = z->parent()) {
-        z->max(max(z->key().end(), z->left(), z->right()));
-        z->min(min(z->key().start(), z->left(), z->right()));
+    for (NodePtr z = x->parent(); z != nullptr; z = z->parent()) {
+        refresh(z);
     }
 
     /*
      * Removing a black node might make some paths from root to leaf contain
      * fewer black nodes than others, or it might make two red nodes adjacent.
+     * Removing a node of an AVL or WAVL tree lowers the subtree of the parent of x.
      */
-    if (y->color() == BLACK) {
-        fixDelete(x);
-    }
-
-    /*
-     * protect subtrees from deletion
-     */
-    y->left(nullptr);
-    y->right(nullptr);
-    /**
-     * delete node from memory.
-     */
-    delete y;
-    return true;
+    rebalanceRemove(x, y == cursor ? nullptr : y, removed, Balance());
 }
 
 /**
- * Ordinary Binary Search Insertion
+ * Ordinary Binary Search
  */
-template<typename T, typename Interval>
-bool IntervalTree<T, Interval>::insert(const Interval& key) {
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+typename IntervalTree<T, Interval, Allocator, Augment, Balance>::NodePtr IntervalTree<T, Interval, Allocator, Augment, Balance>::findParent(const Interval& key) const {
     NodePtr parent = nullptr;
     NodePtr current = this->root_;
 
@@ -361,15 +517,20 @@ bool IntervalTree<T, Interval>::insert(const Interval& key) {
         } else if (key > current->key()) {
             current = current->right();
         } else {
-            return false;
+            return TNIL;
         }
     }
+    return parent;
+}
 
-    NodePtr node = new OrdinaryNode(key, parent);
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::link(NodePtr node) {
+    ++modifications_;
+    NodePtr parent = node->parent();
     /**
      * Insert node in the tree.
      */
-    if (node->parent() == nullptr) {
+    if (parent == nullptr) {
         root_ = node;
     } else if (node->key() < parent->key()) {
         parent->left(node);
@@ -381,20 +542,49 @@ bool IntervalTree<T, Interval>::insert(const Interval& key) {
      * recalculate augmentation.
      */
     for (NodePtr z = node->parent(); z != nullptr; z = z->parent()) {
-        z->max(max(z->key().end(), z->left(), z->right()));
-        z->min(min(z->key().start(), z->left(), z->right()));
+        refresh(z);
     }
 
     /**
      *  Fix the tree
-     *  node is RED
+     *  node is RED, a leaf of rank 1
      */
-    fixInsert(node);
+    rebalanceInsert(node, Balance());
+}
+
+/**
+ * Ordinary Binary Search Insertion
+ */
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+template<typename Key>
+bool IntervalTree<T, Interval, Allocator, Augment, Balance>::insertKey(Key&& key) {
+    NodePtr parent = findParent(key);
+    if (parent == TNIL) {
+        return false;
+    }
+    link(createNode(parent, std::forward<Key>(key)));
     return true;
 }
 
-template<typename T, typename Interval>
-typename IntervalTree<T, Interval>::NodePtr IntervalTree<T, Interval>::minimum(const IntervalTree<T, Interval>::NodePtr node) {
+/**
+ * The key is needed to find the place of the node, so the node is built first.
+ */
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+template<typename... Args>
+bool IntervalTree<T, Interval, Allocator, Augment, Balance>::emplace(Args&&... args) {
+    NodePtr node = createNode(nullptr, std::forward<Args>(args)...);
+    NodePtr parent = findParent(node->key());
+    if (parent == TNIL) {
+        destroyNode(node);
+        return false;
+    }
+    node->parent(parent);
+    link(node);
+    return true;
+}
+
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+typename IntervalTree<T, Interval, Allocator, Augment, Balance>::NodePtr IntervalTree<T, Interval, Allocator, Augment, Balance>::minimum(const IntervalTree<T, Interval, Allocator, Augment, Balance>::NodePtr node) {
     NodePtr found = node;
     while (found->left() != TNIL) {
         found = found->left();
@@ -402,8 +592,8 @@ typename IntervalTree<T, Interval>::NodePtr IntervalTree<T, Interval>::minimum(c
     return found;
 }
 
-template<typename T, typename Interval>
-typename IntervalTree<T, Interval>::NodePtr IntervalTree<T, Interval>::maximum(const IntervalTree<T, Interval>::NodePtr node) {
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+typename IntervalTree<T, Interval, Allocator, Augment, Balance>::NodePtr IntervalTree<T, Interval, Allocator, Augment, Balance>::maximum(const IntervalTree<T, Interval, Allocator, Augment, Balance>::NodePtr node) {
     NodePtr found = node;
     while (found->right() != TNIL) {
         found = found->right();
@@ -415,8 +605,8 @@ typename IntervalTree<T, Interval>::NodePtr IntervalTree<T, Interval>::maximum(c
  * if the right subtree is not null, the successor is the leftmost node in the right subtree
  * else it is the lowest ancestor of x whose left child is also an ancestor of x.
  */
-template<typename T, typename Interval>
-typename IntervalTree<T, Interval>::NodePtr IntervalTree<T, Interval>::successor(const IntervalTree<T, Interval>::NodePtr x) {
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+typename IntervalTree<T, Interval, Allocator, Augment, Balance>::NodePtr IntervalTree<T, Interval, Allocator, Augment, Balance>::successor(const IntervalTree<T, Interval, Allocator, Augment, Balance>::NodePtr x) {
     /**
      * if right subtree is not empty.
      */
@@ -430,23 +620,23 @@ typename IntervalTree<T, Interval>::NodePtr IntervalTree<T, Interval>::successor
     /**
      * right child of parent
      */
-    NodePtr rightChild = nullptr;
+    NodePtr rightChild = x;
     /**
      * while parent is not root of tree and rightChild is really right child of parent.
      */
-    while (parent != TNIL && rightChild == parent->right()) {
+    while (parent != nullptr && rightChild == parent->right()) {
         rightChild = parent;
         parent = parent->parent();
     }
-    return parent;
+    return parent == nullptr ? TNIL : parent;
 }
 
 /**
  * if the left subtree is not null, the predecessor is the rightmost node in the, left subtree
  * else it is the lowest ancestor of x whose right child is also an ancestor of x.
  */
-template<typename T, typename Interval>
-typename IntervalTree<T, Interval>::NodePtr IntervalTree<T, Interval>::predecessor(const IntervalTree<T, Interval>::NodePtr x) {
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+typename IntervalTree<T, Interval, Allocator, Augment, Balance>::NodePtr IntervalTree<T, Interval, Allocator, Augment, Balance>::predecessor(const IntervalTree<T, Interval, Allocator, Augment, Balance>::NodePtr x) {
     /**
      * if left subtree is not empty.
      */
@@ -460,26 +650,116 @@ typename IntervalTree<T, Interval>::NodePtr IntervalTree<T, Interval>::predecess
     /**
      * leftChild of parent.
      */
-    NodePtr leftChild = nullptr;
+    NodePtr leftChild = x;
     /**
      * while parent is not root of tree and leftChild is really left child of parent.
      */
-    while (parent != TNIL && leftChild == parent->left()) {
+    while (parent != nullptr && leftChild == parent->left()) {
         leftChild = parent;
         parent = parent->parent();
     }
-    return parent;
+    return parent == nullptr ? TNIL : parent;
+}
+
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+int IntervalTree<T, Interval, Allocator, Augment, Balance>::blackHeight(const NodePtr node, const NodePtr parent, const Interval* lower, const Interval* upper) {
+    if (node == TNIL) {
+        return 0;
+    }
+    if (node->parent() != parent
+            || (lower != nullptr && !(*lower < node->key()))
+            || (upper != nullptr && !(node->key() < *upper))) {
+        return -1;
+    }
+    if (node->max() != max(node->key().end(), node->left(), node->right())
+            || node->min() != min(node->key().start(), node->left(), node->right())
+            || !(node->aggregate() == aggregate(node->key(), node->left(), node->right()))) {
+        return -1;
+    }
+    int left = blackHeight(node->left(), node, lower, &node->key());
+    int right = blackHeight(node->right(), node, &node->key(), upper);
+    if (left < 0 || right < 0) {
+        return -1;
+    }
+    return balanced(node, left, right, Balance());
+}
+
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+int IntervalTree<T, Interval, Allocator, Augment, Balance>::balanced(NodePtr node, int left, int right, RedBlackBalance) {
+    if (left != right || (node->color() == RED && (node->left()->color() == RED || node->right()->color() == RED))) {
+        return -1;
+    }
+    return left + (node->color() == BLACK ? 1 : 0);
+}
+
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+int IntervalTree<T, Interval, Allocator, Augment, Balance>::balanced(NodePtr node, int left, int right, AvlBalance) {
+    if (node->rank() != 1 + std::max(left, right) || left - right > 1 || right - left > 1) {
+        return -1;
+    }
+    return node->rank();
+}
+
+/**
+ * every rank difference is 1 or 2, leaves have rank 1.
+ */
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+int IntervalTree<T, Interval, Allocator, Augment, Balance>::balanced(NodePtr node, int left, int right, WavlBalance) {
+    int l = node->rank() - left;
+    int r = node->rank() - right;
+    if (l < 1 || l > 2 || r < 1 || r > 2
+            || (node->left() == TNIL && node->right() == TNIL && node->rank() != 1)) {
+        return -1;
+    }
+    return node->rank();
 }
 
-template<typename T, typename Interval>
-void IntervalTree<T, Interval>::overlapSearch(const NodePtr _root_, const Interval& i, std::set<Interval>& res) {
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+int IntervalTree<T, Interval, Allocator, Augment, Balance>::balanced(NodePtr node, int, int, TreapBalance) {
+    if (node->rank() <= 0 || node->left()->rank() > node->rank() || node->right()->rank() > node->rank()) {
+        return -1;
+    }
+    return 0;
+}
+
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+typename IntervalTree<T, Interval, Allocator, Augment, Balance>::NodePtr IntervalTree<T, Interval, Allocator, Augment, Balance>::clone(const IntervalTree<T, Interval, Allocator, Augment, Balance>::NodePtr node, NodePtr parent) {
+    if (node == TNIL) {
+        return TNIL;
+    }
+    NodePtr copy = createNode(parent, node->key());
+    copy->rank(node->rank());
+    copy->max(node->max());
+    copy->min(node->min());
+    copy->aggregate(node->aggregate());
+    copy->left(clone(node->left(), copy));
+    copy->right(clone(node->right(), copy));
+    return copy;
+}
+
+/**
+ * The left subtree is freed recursively, the right one in the loop,
+ * the depth of recursion is bounded by the height of the tree.
+ */
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::destroy(NodePtr node) {
+    while (node != TNIL) {
+        destroy(node->left());
+        NodePtr right = node->right();
+        destroyNode(node);
+        node = right;
+    }
+}
+
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::overlapSearch(const NodePtr _root_, const Interval& i, std::set<Interval>& res) const {
     using std::stack;
 
     NodePtr curr = _root_;
     if (curr == TNIL) {
         return;
     }
-    std::stack<NodePtr> s;
+    NodeStack s{PointerAllocator(alloc_)};
     s.push(curr);
     while (!s.empty()) {
         curr = s.top();
@@ -530,8 +810,566 @@ void IntervalTree<T, Interval>::overlapSearch(const NodePtr _root_, const Interv
 
 }
 
-template<typename T, typename Interval>
-const Interval& IntervalTree<T, Interval>::search(const NodePtr node, const Interval& key) {
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::linkMiddle(NodePtr parent, NodePtr middle, NodePtr left, NodePtr right) {
+    middle->parent(parent);
+    middle->left(left);
+    middle->right(right);
+    if (left != TNIL) {
+        left->parent(middle);
+    }
+    if (right != TNIL) {
+        right->parent(middle);
+    }
+    if (parent == nullptr) {
+        root_ = middle;
+    } else if (middle->key() < parent->key()) {
+        parent->left(middle);
+    } else {
+        parent->right(middle);
+    }
+
+    /**
+     * recalculate augmentation.
+     */
+    for (NodePtr z = middle; z != nullptr; z = z->parent()) {
+        refresh(z);
+    }
+}
+
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+typename IntervalTree<T, Interval, Allocator, Augment, Balance>::NodePtr IntervalTree<T, Interval, Allocator, Augment, Balance>::join(NodePtr left, int leftHeight, NodePtr middle, NodePtr right, int rightHeight, int& height, RedBlackBalance) {
+    /*
+     * a red root is made black, the subtrees stay valid red-black trees one black node higher.
+     */
+    leftHeight += left->color() == RED ? 1 : 0;
+    rightHeight += right->color() == RED ? 1 : 0;
+    detach(left, RedBlackBalance());
+    detach(right, RedBlackBalance());
+
+    if (leftHeight == rightHeight) {
+        linkMiddle(nullptr, middle, left, right);
+        middle->color(BLACK);
+        height = leftHeight + 1;
+        return root_;
+    }
+
+    /*
+     * y - the first black node of the spine with the black height of the lower subtree,
+     * the middle node takes its place and y becomes its child.
+     */
+    NodePtr parent = nullptr;
+    if (leftHeight > rightHeight) {
+        NodePtr y = left;
+        for (int h = leftHeight; !(y->color() == BLACK && h == rightHeight); y = y->right()) {
+            h -= y->color() == BLACK ? 1 : 0;
+            parent = y;
+            ++spineSteps_;
+        }
+        root_ = left;
+        linkMiddle(parent, middle, y, right);
+    } else {
+        NodePtr y = right;
+        for (int h = rightHeight; !(y->color() == BLACK && h == leftHeight); y = y->left()) {
+            h -= y->color() == BLACK ? 1 : 0;
+            parent = y;
+            ++spineSteps_;
+        }
+        root_ = right;
+        linkMiddle(parent, middle, left, y);
+    }
+    middle->color(RED);
+    height = std::max(leftHeight, rightHeight) + (fixInsert(middle) ? 1 : 0);
+    return root_;
+}
+
+/**
+ * c - the first node of the spine of the higher subtree not higher than the lower
+ * subtree + 1, the middle node takes its place and c becomes its child.
+ */
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+typename IntervalTree<T, Interval, Allocator, Augment, Balance>::NodePtr IntervalTree<T, Interval, Allocator, Augment, Balance>::join(NodePtr left, NodePtr middle, NodePtr right, AvlBalance) {
+    detach(left, AvlBalance());
+    detach(right, AvlBalance());
+    int leftHeight = left->rank();
+    int rightHeight = right->rank();
+
+    NodePtr parent = nullptr;
+    if (leftHeight > rightHeight + 1) {
+        NodePtr c = left;
+        for (; c->rank() > rightHeight + 1; c = c->right()) {
+            parent = c;
+            ++spineSteps_;
+        }
+        root_ = left;
+        linkMiddle(parent, middle, c, right);
+    } else if (rightHeight > leftHeight + 1) {
+        NodePtr c = right;
+        for (; c->rank() > leftHeight + 1; c = c->left()) {
+            parent = c;
+            ++spineSteps_;
+        }
+        root_ = right;
+        linkMiddle(parent, middle, left, c);
+    } else {
+        linkMiddle(nullptr, middle, left, right);
+    }
+    setHeight(middle);
+    fixAvl(parent);
+    return root_;
+}
+
+/**
+ * c - the first node of the spine of the higher subtree with a rank not above the rank
+ * r of the lower subtree, so r - 1 <= rank(c) <= r, the middle node of rank r + 1
+ * takes its place and c becomes its child. The middle node can be a 0-child.
+ */
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+typename IntervalTree<T, Interval, Allocator, Augment, Balance>::NodePtr IntervalTree<T, Interval, Allocator, Augment, Balance>::join(NodePtr left, NodePtr middle, NodePtr right, WavlBalance) {
+    detach(left, WavlBalance());
+    detach(right, WavlBalance());
+    int leftRank = left->rank();
+    int rightRank = right->rank();
+
+    if (leftRank > rightRank + 1) {
+        NodePtr parent = nullptr;
+        NodePtr c = left;
+        for (; c->rank() > rightRank; c = c->right()) {
+            parent = c;
+            ++spineSteps_;
+        }
+        root_ = left;
+        linkMiddle(parent, middle, c, right);
+        middle->rank(rightRank + 1);
+    } else if (rightRank > leftRank + 1) {
+        NodePtr parent = nullptr;
+        NodePtr c = right;
+        for (; c->rank() > leftRank; c = c->left()) {
+            parent = c;
+            ++spineSteps_;
+        }
+        root_ = right;
+        linkMiddle(parent, middle, left, c);
+        middle->rank(leftRank + 1);
+    } else {
+        linkMiddle(nullptr, middle, left, right);
+        setHeight(middle);
+    }
+    fixWavlInsert(middle);
+    return root_;
+}
+
+/**
+ * The middle node keeps its priority and sinks from the root to its place.
+ */
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+typename IntervalTree<T, Interval, Allocator, Augment, Balance>::NodePtr IntervalTree<T, Interval, Allocator, Augment, Balance>::join(NodePtr left, NodePtr middle, NodePtr right, TreapBalance) {
+    detach(left, TreapBalance());
+    detach(right, TreapBalance());
+    linkMiddle(nullptr, middle, left, right);
+    siftDown(middle);
+    return root_;
+}
+
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+typename IntervalTree<T, Interval, Allocator, Augment, Balance>::NodePtr IntervalTree<T, Interval, Allocator, Augment, Balance>::join(NodePtr left, NodePtr right) {
+    ++modifications_;
+    if (left == TNIL || right == TNIL) {
+        root_ = left == TNIL ? right : left;
+        detach(root_, Balance());
+        return root_;
+    }
+    detach(right, Balance());
+    root_ = right;
+    NodePtr middle = minimum(right);
+    unlink(middle);
+    return join(left, middle, root_);
+}
+
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::split(NodePtr node, int height, T at, NodePtr& left, int& leftHeight, NodePtr& right, int& rightHeight) {
+    if (node == TNIL) {
+        left = TNIL;
+        right = TNIL;
+        leftHeight = 0;
+        rightHeight = 0;
+        return;
+    }
+    NodePtr l = node->left();
+    NodePtr r = node->right();
+    /*
+     * the black height of both children, only red-black joins use it.
+     */
+    int childHeight = height - (node->color() == BLACK ? 1 : 0);
+    if (node->key().start() < at) {
+        NodePtr rl, rr;
+        int rlHeight;
+        split(r, childHeight, at, rl, rlHeight, rr, rightHeight);
+        left = join(l, childHeight, node, rl, rlHeight, leftHeight, Balance());
+        right = rr;
+    } else {
+        NodePtr ll, lr;
+        int lrHeight;
+        split(l, childHeight, at, ll, leftHeight, lr, lrHeight);
+        left = ll;
+        right = join(lr, lrHeight, node, r, childHeight, rightHeight, Balance());
+    }
+}
+
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+typename IntervalTree<T, Interval, Allocator, Augment, Balance>::NodePtr IntervalTree<T, Interval, Allocator, Augment, Balance>::build(const PointerVector& nodes, std::size_t first, std::size_t last, NodePtr parent, int depth, int redDepth) {
+    if (first == last) {
+        return TNIL;
+    }
+    std::size_t middle = first + (last - first) / 2;
+    NodePtr node = nodes[middle];
+    node->parent(parent);
+    node->left(build(nodes, first, middle, node, depth + 1, redDepth));
+    node->right(build(nodes, middle + 1, last, node, depth + 1, redDepth));
+    initBuilt(node, depth, redDepth, Balance());
+    refresh(node);
+    return node;
+}
+
+/**
+ * A parent comes before its children in the level order, so the priorities sorted
+ * in descending order keep the heap order.
+ */
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::prioritize(NodePtr root, std::size_t size, TreapBalance) {
+    std::vector<int> priorities(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        priorities[i] = nextPriority();
+    }
+    std::sort(priorities.begin(), priorities.end(), std::greater<int>());
+    PointerVector level{PointerAllocator(alloc_)};
+    level.reserve(size);
+    if (root != TNIL) {
+        level.push_back(root);
+    }
+    for (std::size_t i = 0; i < level.size(); ++i) {
+        NodePtr node = level[i];
+        node->rank(priorities[i]);
+        if (node->left() != TNIL) {
+            level.push_back(node->left());
+        }
+        if (node->right() != TNIL) {
+            level.push_back(node->right());
+        }
+    }
+}
+
+/**
+ * Filter of a join based tree: a subtree with its minimal end after the watermark stays
+ * whole, otherwise both children are filtered and joined back with the node, or without
+ * it if it expired. The joins of live nodes know the black heights, so they cost the
+ * difference of the heights only; children back with the heights and balance fields
+ * they had are linked to the node as they are, the node keeps its place.
+ *
+ * see also "Just Join for Parallel Ordered Sets", G. E. Blelloch, D. Ferizovic, Y. Sun, 2016.
+ */
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+typename IntervalTree<T, Interval, Allocator, Augment, Balance>::NodePtr IntervalTree<T, Interval, Allocator, Augment, Balance>::expire(NodePtr node, int height, T watermark, int& restHeight, std::size_t& expired) {
+    if (node == TNIL || watermark < node->aggregate()) {
+        restHeight = height;
+        return node;
+    }
+    int childHeight = height - (node->color() == BLACK ? 1 : 0);
+    int leftRank = node->left()->rank(), rightRank = node->right()->rank();
+    int leftHeight, rightHeight;
+    NodePtr left = expire(node->left(), childHeight, watermark, leftHeight, expired);
+    NodePtr right = expire(node->right(), childHeight, watermark, rightHeight, expired);
+    if (watermark < node->key().end()) {
+        if (leftHeight != childHeight || rightHeight != childHeight || left->rank() != leftRank || right->rank() != rightRank) {
+            return join(left, leftHeight, node, right, rightHeight, restHeight, Balance());
+        }
+        node->left(left);
+        node->right(right);
+        if (left != TNIL) {
+            left->parent(node);
+        }
+        if (right != TNIL) {
+            right->parent(node);
+        }
+        refresh(node);
+        restHeight = height;
+        return node;
+    }
+    destroyNode(node);
+    ++expired;
+    NodePtr rest = join(left, right);
+    restHeight = joinHeight(rest, Balance());
+    return rest;
+}
+
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+std::size_t IntervalTree<T, Interval, Allocator, Augment, Balance>::expireBefore(T watermark) {
+    static_assert(std::is_base_of<MinEndAugmentation<T>, Augment>::value,
+            "expireBefore: Augment must be MinEndAugmentation<T>");
+    if (root_ == TNIL || watermark < root_->aggregate()) {
+        return 0;
+    }
+    std::size_t expired = 0;
+    int height;
+    root_ = expire(root_, joinHeight(root_, Balance()), watermark, height, expired);
+    detach(root_, Balance());
+    ++modifications_;
+    return expired;
+}
+
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+IntervalTree<T, Interval, Allocator, Augment, Balance> IntervalTree<T, Interval, Allocator, Augment, Balance>::split(T at) {
+    IntervalTree res(get_allocator());
+    NodePtr left, right;
+    ++version_;
+    split(root_, at, left, right);
+    res.join(right, TNIL);
+    join(left, TNIL);
+    return res;
+}
+
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+IntervalTree<T, Interval, Allocator, Augment, Balance> IntervalTree<T, Interval, Allocator, Augment, Balance>::join(IntervalTree&& left, IntervalTree&& right) {
+    if (!left.empty() && !right.empty() && !(maximum(left.root_)->key().start() < minimum(right.root_)->key().start())) {
+        throw std::invalid_argument("join: the trees overlap");
+    }
+    IntervalTree res(left.get_allocator());
+    if (!(left.alloc_ == right.alloc_)) {
+        IntervalTree copy = right.clone(left.get_allocator());
+        right.clear();
+        right.steal(copy);
+    }
+    NodePtr l = left.root_;
+    NodePtr r = right.root_;
+    left.root_ = TNIL;
+    right.root_ = TNIL;
+    ++left.version_;
+    ++right.version_;
+    ++left.modifications_;
+    ++right.modifications_;
+    res.join(l, r);
+    return res;
+}
+
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::collect(NodePtr node, PointerVector& nodes) const {
+    NodeStack s{PointerAllocator(alloc_)};
+    while (node != TNIL || !s.empty()) {
+        while (node != TNIL) {
+            s.push(node);
+            node = node->left();
+        }
+        node = s.top();
+        s.pop();
+        nodes.push_back(node);
+        node = node->right();
+    }
+}
+
+/**
+ * Everything that can throw is done before the first node is relinked or freed.
+ */
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::mergeFrom(IntervalTree&& other) {
+    if (this == &other || other.empty()) {
+        return;
+    }
+    if (!(alloc_ == other.alloc_)) {
+        IntervalTree copy = other.clone(get_allocator());
+        other.clear();
+        mergeFrom(std::move(copy));
+        return;
+    }
+    PointerVector a{PointerAllocator(alloc_)};
+    PointerVector b{PointerAllocator(alloc_)};
+    PointerVector merged{PointerAllocator(alloc_)};
+    collect(root_, a);
+    collect(other.root_, b);
+    merged.reserve(a.size() + b.size());
+
+    std::size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (a[i]->key() < b[j]->key()) {
+            merged.push_back(a[i++]);
+        } else if (b[j]->key() < a[i]->key()) {
+            merged.push_back(b[j++]);
+        } else {
+            merged.push_back(a[i++]);
+            destroyNode(b[j++]);
+        }
+    }
+    merged.insert(merged.end(), a.begin() + i, a.end());
+    merged.insert(merged.end(), b.begin() + j, b.end());
+
+    other.root_ = TNIL;
+    ++other.version_;
+    ++other.modifications_;
+    join(build(merged), TNIL);
+}
+
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::retain(const IntervalTree& other, bool common) {
+    if (this == &other) {
+        if (!common) {
+            clear();
+        }
+        return;
+    }
+    PointerVector a{PointerAllocator(alloc_)};
+    PointerVector b{PointerAllocator(alloc_)};
+    PointerVector kept{PointerAllocator(alloc_)};
+    collect(root_, a);
+    collect(other.root_, b);
+    kept.reserve(a.size());
+
+    std::size_t j = 0;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        while (j < b.size() && b[j]->key() < a[i]->key()) {
+            ++j;
+        }
+        bool found = j < b.size() && a[i]->key() == b[j]->key();
+        if (found == common) {
+            kept.push_back(a[i]);
+        } else {
+            destroyNode(a[i]);
+        }
+    }
+
+    join(build(kept), TNIL);
+}
+
+/**
+ * The left spine is followed only into subtrees with max above the query start and
+ * an accepted aggregate, a skipped subtree holds no interval to report. Nodes come in
+ * the order of starts, so the traversal stops at the first node starting at or after
+ * the query end.
+ */
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+template<typename Emit, typename Accept>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::orderedOverlapSearch(const Interval& i, Emit emit, Accept accept) const {
+    NodeStack s{PointerAllocator(alloc_)};
+    NodePtr curr = root_;
+    while (curr != TNIL || !s.empty()) {
+        while (curr != TNIL && curr->max() > i.start() && accept(curr->aggregate())) {
+            /*
+             * the right subtree comes after the left one, load it meanwhile.
+             */
+            prefetch(curr->right());
+            s.push(curr);
+            curr = curr->left();
+        }
+        if (s.empty()) {
+            return;
+        }
+        curr = s.top();
+        s.pop();
+        if (!(curr->key().start() < i.end())) {
+            return;
+        }
+        if (overlap(curr->key(), i) && accept(Augment::value(curr->key()))) {
+            emit(curr);
+        }
+        curr = curr->right();
+        /*
+         * the right subtree and the ancestors to come start later than min.
+         */
+        if (curr != TNIL && !(curr->min() < i.end())) {
+            return;
+        }
+    }
+}
+
+/**
+ * Asynchronous memory access chaining (AMAC): every slot holds the stack of one
+ * search. A step pops a node the search had prefetched when it pushed the node, so
+ * the step does not wait for memory, prefetches the children and passes on to the
+ * next slot. The subtree is pruned when the node is popped, max and min of the node
+ * itself are checked instead of the children, not to touch nodes not yet loaded.
+ * A slot whose search has finished takes the next query.
+ *
+ * see also "Asynchronous Memory Access Chaining", O. Kocberber, B. Falsafi, B. Grot, 2015.
+ */
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+template<typename Iterator, typename Visitor>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::batchOverlapSearch(Iterator first, Iterator last, Visitor visit, std::size_t group) const {
+    typedef typename AllocatorTraits::template rebind_alloc<PointerVector> StackAllocator;
+    typedef typename AllocatorTraits::template rebind_alloc<const Interval*> QueryAllocator;
+    typedef typename AllocatorTraits::template rebind_alloc<std::size_t> PositionAllocator;
+
+    if (root_ == TNIL || group == 0) {
+        return;
+    }
+    std::vector<PointerVector, StackAllocator> stacks(group, PointerVector(PointerAllocator(alloc_)), StackAllocator(alloc_));
+    std::vector<const Interval*, QueryAllocator> queries(group, nullptr, QueryAllocator(alloc_));
+    std::vector<std::size_t, PositionAllocator> positions(group, 0, PositionAllocator(alloc_));
+
+    std::size_t position = 0;
+    std::size_t active = 0;
+    for (std::size_t slot = 0; slot < group && first != last; ++slot, ++first, ++position, ++active) {
+        queries[slot] = &*first;
+        positions[slot] = position;
+        stacks[slot].push_back(root_);
+    }
+    prefetch(root_);
+
+    while (active > 0) {
+        for (std::size_t slot = 0; slot < group; ++slot) {
+            PointerVector& s = stacks[slot];
+            if (s.empty()) {
+                continue;
+            }
+            const Interval& i = *queries[slot];
+            NodePtr curr = s.back();
+            s.pop_back();
+            if (curr->max() > i.start() && curr->min() < i.end()) {
+                if (overlap(curr->key(), i)) {
+                    visit(positions[slot], curr->key());
+                }
+                if (curr->left() != TNIL) {
+                    prefetch(curr->left());
+                    s.push_back(curr->left());
+                }
+                if (curr->right() != TNIL) {
+                    prefetch(curr->right());
+                    s.push_back(curr->right());
+                }
+            }
+            if (s.empty()) {
+                if (first != last) {
+                    queries[slot] = &*first;
+                    positions[slot] = position++;
+                    ++first;
+                    s.push_back(root_);
+                } else {
+                    --active;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Iterative in-order traversal, the stack holds the path to the current node.
+ */
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+template<typename Visitor>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::forEach(Visitor visit) const {
+    NodeStack s{PointerAllocator(alloc_)};
+    NodePtr curr = root_;
+    while (curr != TNIL || !s.empty()) {
+        while (curr != TNIL) {
+            s.push(curr);
+            curr = curr->left();
+        }
+        curr = s.top();
+        s.pop();
+        visit(curr->key());
+        curr = curr->right();
+    }
+}
+
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+const Interval& IntervalTree<T, Interval, Allocator, Augment, Balance>::search(const NodePtr node, const Interval& key) {
     NodePtr found = node;
     while (found != TNIL && found->key() != key) {
         if (key < found->key()) {
@@ -543,8 +1381,83 @@ const Interval& IntervalTree<T, Interval>::search(const NodePtr node, const Inte
     return found->key();
 }
 
-template<typename T, typename Interval>
-const Interval& IntervalTree<T, Interval>::search(const NodePtr node, long offset) {
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+typename IntervalTree<T, Interval, Allocator, Augment, Balance>::Handle IntervalTree<T, Interval, Allocator, Augment, Balance>::find(unsigned long offset) const {
+    NodePtr found = root_;
+    while (found != TNIL && found->key().start() != offset) {
+        if (offset < found->key().start()) {
+            found = found->left();
+        } else {
+            found = found->right();
+        }
+    }
+    return Handle(found != TNIL ? found : nullptr);
+}
+
+/**
+ * max of an ancestor depends on the changed end only through the child on the path,
+ * once an ancestor keeps its max all the ones above keep theirs. min depends on
+ * starts only and stays. An aggregate may depend on the end, with one the walk
+ * goes up to the root.
+ */
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+void IntervalTree<T, Interval, Allocator, Augment, Balance>::updateEnd(Handle handle, T end) {
+    ++modifications_;
+    NodePtr node = handle.node_;
+    node->key(Interval::valueOf(node->key().start(), end));
+    for (; node != nullptr; node = node->parent()) {
+        unsigned long updated = max(node->key().end(), node->left(), node->right());
+        if (updated == node->max() && std::is_empty<AggregateValue>::value) {
+            break;
+        }
+        node->max(updated);
+        node->aggregate(aggregate(node->key(), node->left(), node->right()));
+    }
+}
+
+/**
+ * Finger search: from the finger climb while the parent is still on the near side of
+ * the offset. The subtree reached holds every start between the finger and the offset,
+ * so the ordinary search continues down from it. Both walks are as long as the height
+ * of the subtree spanning the finger and the offset.
+ */
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+const Interval& IntervalTree<T, Interval, Allocator, Augment, Balance>::search(unsigned long offset, Finger& finger) const {
+    NodePtr from = root_;
+    if (finger.tree_ == this && finger.version_ == version_ && finger.node_ != nullptr) {
+        from = finger.node_;
+        if (from->key().start() < offset) {
+            while (from->parent() != nullptr && from->parent()->key().start() < offset) {
+                from = from->parent();
+            }
+        } else if (offset < from->key().start()) {
+            while (from->parent() != nullptr && offset < from->parent()->key().start()) {
+                from = from->parent();
+            }
+        }
+        if (from->key().start() != offset && from->parent() != nullptr && from->parent()->key().start() == offset) {
+            from = from->parent();
+        }
+    }
+
+    NodePtr found = from;
+    NodePtr last = nullptr;
+    while (found != TNIL && found->key().start() != offset) {
+        last = found;
+        if (offset < found->key().start()) {
+            found = found->left();
+        } else {
+            found = found->right();
+        }
+    }
+    finger.tree_ = this;
+    finger.version_ = version_;
+    finger.node_ = found != TNIL ? found : last;
+    return found->key();
+}
+
+template<typename T, typename Interval, typename Allocator, typename Augment, typename Balance>
+const Interval& IntervalTree<T, Interval, Allocator, Augment, Balance>::search(const NodePtr node, long offset) {
     NodePtr found = node;
     while (found != TNIL && found->key().start() != offset) {
         if (offset < found->key().start()) {
@@ -556,10 +1469,10 @@ const Interval& IntervalTree<T, Interval>::search(const NodePtr node, long offse
     return found->key();
 }
 
-template<typename T, typename Interval>
-std::ostream& HierarchyWriter<T, Interval>::print(std::ostream& os,const typename IntervalTree<T, Interval>::NodePtr root, std::string indent, bool last) const {
+template<typename T, typename Interval, typename Tree>
+std::ostream& HierarchyWriter<T, Interval, Tree>::print(std::ostream& os,const typename Tree::NodePtr root, std::string indent, bool last) const {
     using std::endl;
-    if (root != IntervalTree<T, Interval>::TNIL) {
+    if (root != Tree::TNIL) {
         os << indent;
         if (last) {
             os << "R----";
@@ -570,16 +1483,16 @@ std::ostream& HierarchyWriter<T, Interval>::print(std::ostream& os,const typenam
         }
 
         os << "{key:" << root->key() << ", max:" << root->max() << ", min:" << root->min() << "}" << "("
-             << (root->color() == IntervalTree<T, Interval>::RED ? "RED" : "BLACK") << ")" << endl;
+             << (root->color() == Tree::RED ? "RED" : "BLACK") << ")" << endl;
         print(os, root->left(), indent, false);
         print(os, root->right(), indent, true);
     }
     return os;
 }
 
-template<typename T, typename Interval>
-std::ostream& SequenceWriter<T, Interval>::print(std::ostream& os, const typename IntervalTree<T, Interval>::NodePtr root) const {
-     if (root == IntervalTree<T, Interval>::TNIL) {
+template<typename T, typename Interval, typename Tree>
+std::ostream& SequenceWriter<T, Interval, Tree>::print(std::ostream& os, const typename Tree::NodePtr root) const {
+     if (root == Tree::TNIL) {
          return os;
      }
      print(os, root->left());
@@ -12,15 +12,130 @@
 #include <algorithm>
 #include <set>
 #include <cassert>
+#include <utility>
+#include <memory>
+#include <vector>
+#include <stack>
+#include <type_traits>
+#include <stdexcept>
+#include <functional>
+#include <limits>
+#if __cplusplus >= 201703L
+#include <memory_resource>
+#endif
 
 #include <Interval.hpp>
 
-template<typename T, typename Interval>
+template<typename T, typename Interval, typename Tree>
 class HierarchyWriter;
 
-template<typename T, typename Interval>
+template<typename T, typename Interval, typename Tree>
 class SequenceWriter;
 
+/**
+ * Augmentation policy of IntervalTree: a value per node summarizing its subtree,
+ * kept up to date next to max and min by insertions, removals and rotations.
+ *
+ *   struct MaxPriority {
+ *       typedef int value_type;
+ *       static int identity() { return INT_MIN; }
+ *       static int value(const Task& key) { return key.priority(); }
+ *       static int combine(int a, int b) { return std::max(a, b); }
+ *   };
+ *
+ * combine must be associative with identity as its neutral element (a monoid),
+ * value_type must be comparable with ==, isValid() checks the aggregates.
+ * NoAugmentation, the default, adds nothing to the nodes.
+ */
+struct NoAugmentation {
+    struct value_type {
+        bool operator==(const value_type&) const {
+            return true;
+        }
+    };
+
+    static value_type identity() {
+        return value_type();
+    }
+
+    template<typename Interval>
+    static value_type value(const Interval&) {
+        return value_type();
+    }
+
+    static value_type combine(const value_type&, const value_type&) {
+        return value_type();
+    }
+};
+
+/**
+ * The minimal end in a subtree: a subtree whose aggregate is after the watermark
+ * has nothing to expire, see IntervalTree::expireBefore, which requires it.
+ */
+template<typename T>
+struct MinEndAugmentation {
+    typedef T value_type;
+
+    static value_type identity() {
+        return std::numeric_limits<T>::max();
+    }
+
+    template<typename Interval>
+    static value_type value(const Interval& key) {
+        return key.end();
+    }
+
+    static value_type combine(const value_type& a, const value_type& b) {
+        return std::min(a, b);
+    }
+};
+
+/**
+ * the aggregate of a node, an empty value_type takes no space in the node.
+ */
+template<typename Value, bool = std::is_empty<Value>::value>
+class AugmentationField {
+private:
+    Value aggregate_;
+public:
+    AugmentationField() : aggregate_() {}
+
+    const Value& aggregate() const {
+        return aggregate_;
+    }
+    void aggregate(const Value& value) {
+        aggregate_ = value;
+    }
+};
+
+template<typename Value>
+class AugmentationField<Value, true> {
+public:
+    Value aggregate() const {
+        return Value();
+    }
+    void aggregate(const Value&) {
+    }
+};
+
+/**
+ * Balancing policies of IntervalTree, all behind the same interface.
+ *
+ * RedBlackBalance - the default, O(1) rotations per insertion and removal.
+ * AvlBalance - the shallowest tree (height <= 1.44 log n) for read-mostly data,
+ *   removals may rotate up to the root.
+ * WavlBalance - weak AVL: the AVL tree while there are no removals, at most two
+ *   rotations per removal, the height stays below 2 log n.
+ * TreapBalance - random priorities, expected O(log n) depth, removals do not rotate.
+ *
+ * see also "Rank-Balanced Trees", B. Haeupler, S. Sen, R. E. Tarjan, 2015;
+ * "Randomized search trees", R. Seidel, C. R. Aragon, 1996.
+ */
+struct RedBlackBalance {};
+struct AvlBalance {};
+struct WavlBalance {};
+struct TreapBalance {};
+
 /**
  * In computer science, an interval tree is a tree data structure to hold intervals.
  * Specifically, it allows one to efficiently find all intervals that overlap with
@@ -37,12 +152,19 @@ class SequenceWriter;
  * Ronald L. Rivest
  * Clifford Stein
  *
+ * Nodes and the temporaries of searches are allocated by the Allocator
+ * (rebound to the node type), see also PmrIntervalTree.
+ * Augment adds a custom aggregate per subtree, see NoAugmentation.
+ * Balance selects the balancing, see RedBlackBalance.
  */
 
-template<typename T, typename Interval = IntervalT<T>>
+template<typename T, typename Interval = IntervalT<T>, typename Allocator = std::allocator<Interval>,
+        typename Augment = NoAugmentation, typename Balance = RedBlackBalance>
 class IntervalTree {
 private:
 
+    typedef typename Augment::value_type AggregateValue;
+
     enum Color {
         BLACK, RED
     };
@@ -50,9 +172,13 @@ private:
     /**
      * type that represents a node in the tree
      */
-    class OrdinaryNode {
+    class OrdinaryNode : public AugmentationField<AggregateValue> {
     private:
-        Color color_;
+        /**
+         * color of red-black trees, rank of AVL (the height) and WAVL trees,
+         * priority of treaps. 0 for TNIL: BLACK, rank 0, the lowest priority.
+         */
+        int balance_;
         OrdinaryNode *parent_;
         OrdinaryNode *left_;
         OrdinaryNode *right_;
@@ -67,7 +193,7 @@ private:
         unsigned long min_;
 
         OrdinaryNode() {
-            color_ = BLACK;
+            balance_ = BLACK;
             parent_ = nullptr;
             left_ = this;
             right_ = this;
@@ -77,25 +203,36 @@ private:
     public:
         /**
          * new OrdinaryNode must be RED.
+         * The key is constructed in place from args.
          */
-        OrdinaryNode(const Interval& key_, OrdinaryNode* parent) {
-            color_ = RED;
-            this->parent_ = parent;
-            left_ = TNIL;
-            right_ = TNIL;
-            this->key_ = key_;
-            max_ = this->key_.end();
-            min_ = this->key_.start();
+        template<typename... Args>
+        explicit OrdinaryNode(OrdinaryNode* parent, Args&&... args) :
+                balance_(RED), parent_(parent), left_(TNIL), right_(TNIL), key_(std::forward<Args>(args)...) {
+            max_ = key_.end();
+            min_ = key_.start();
+            this->aggregate(Augment::value(key_));
         }
 
+        OrdinaryNode(const Interval& key_, OrdinaryNode* parent): OrdinaryNode(parent, key_) {}
+
         OrdinaryNode(const Interval& key_): OrdinaryNode(key_, nullptr) {}
 
         Color color() const {
-            return color_;
+            return static_cast<Color>(balance_);
         }
         void color(Color color_) {
             assert(left_ != this && right_ != this);
-            this->color_ = color_;
+            balance_ = color_;
+        }
+        /**
+         * the balance field as is: rank, priority of treaps.
+         */
+        int rank() const {
+            return balance_;
+        }
+        void rank(int rank_) {
+            assert(left_ != this && right_ != this);
+            balance_ = rank_;
         }
         OrdinaryNode* parent() const {
             return parent_;
@@ -138,25 +275,64 @@ private:
             assert(left_ != this && right_ != this);
             min_ = _min_;
         }
-        ~OrdinaryNode() {
-            if (left_ != TNIL) {
-                delete left_;
-            }
-            if (right_ != TNIL) {
-                delete right_;
-            }
-        }
         friend class IntervalTree;
     };
 
     typedef OrdinaryNode* NodePtr;
 
+    typedef std::allocator_traits<Allocator> AllocatorTraits;
+    typedef typename AllocatorTraits::template rebind_alloc<OrdinaryNode> NodeAllocator;
+    typedef std::allocator_traits<NodeAllocator> NodeTraits;
+    typedef typename AllocatorTraits::template rebind_alloc<NodePtr> PointerAllocator;
+    typedef std::vector<NodePtr, PointerAllocator> PointerVector;
+    typedef std::stack<NodePtr, PointerVector> NodeStack;
+
 private:
     NodePtr root_;
+    NodeAllocator alloc_;
+    /**
+     * changed whenever a node is freed or leaves the tree, see Finger.
+     */
+    unsigned long version_;
+    /**
+     * changed whenever an interval is added, removed or changed, see modifications().
+     */
+    unsigned long modifications_;
+    /**
+     * xorshift state of treap priorities.
+     */
+    unsigned long seed_;
+    /**
+     * nodes walked by joins along the spines, see spineSteps().
+     */
+    unsigned long spineSteps_;
 
     static OrdinaryNode nilNode;
     static OrdinaryNode *const TNIL;
 
+    template<typename... Args>
+    NodePtr createNode(Args&&... args) {
+        NodePtr node = NodeTraits::allocate(alloc_, 1);
+        try {
+            NodeTraits::construct(alloc_, node, std::forward<Args>(args)...);
+        } catch (...) {
+            NodeTraits::deallocate(alloc_, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    void destroyNode(NodePtr node) {
+        ++version_;
+        NodeTraits::destroy(alloc_, node);
+        NodeTraits::deallocate(alloc_, node, 1);
+    }
+
+    /**
+     * free the subtree.
+     */
+    void destroy(NodePtr node);
+
     static const Interval& search(const NodePtr node, const Interval& key);
     static const Interval& search(const NodePtr node, long offset);
 
@@ -164,7 +340,31 @@ private:
      * Iterative implementation.
      * see https://www.bowdoin.edu/~ltoma/teaching/cs231/spring14/Lectures/10-augmentedTrees/augtrees.pdf
      */
-    static void overlapSearch(const NodePtr _root_, const Interval& i, std::set<Interval>& res);
+    void overlapSearch(const NodePtr _root_, const Interval& i, std::set<Interval>& res) const;
+
+    /**
+     * In-order traversal pruned by max, calls emit(NodePtr) for the nodes of the
+     * overlapping intervals in the order of starts. Subtrees and intervals whose
+     * aggregate (value) accept(const AggregateValue&) rejects are skipped.
+     */
+    template<typename Emit, typename Accept>
+    void orderedOverlapSearch(const Interval& i, Emit emit, Accept accept) const;
+
+    template<typename Emit>
+    void orderedOverlapSearch(const Interval& i, Emit emit) const {
+        orderedOverlapSearch(i, emit, [](const AggregateValue&) {
+            return true;
+        });
+    }
+
+    /**
+     * hint the cache to load the node, the search does not wait for it.
+     */
+    static void prefetch(const NodePtr node) {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(node);
+#endif
+    }
 
    /**
      * fix the rb tree modified by the delete operation
@@ -177,8 +377,87 @@ private:
      *    - the root is RED;
      *    - both k and k's parent are RED.
      *  The node pointed to by k is always red.
+     *  Returns true if the root was made black, the black height of the tree grew by 1.
      */
-    void fixInsert(NodePtr k);
+    bool fixInsert(NodePtr k);
+
+    /**
+     * restore the balance after the new node was linked as a leaf.
+     */
+    void rebalanceInsert(NodePtr node, RedBlackBalance) {
+        fixInsert(node);
+    }
+    void rebalanceInsert(NodePtr node, AvlBalance) {
+        fixAvl(node->parent());
+    }
+    void rebalanceInsert(NodePtr node, WavlBalance) {
+        fixWavlInsert(node);
+    }
+    void rebalanceInsert(NodePtr node, TreapBalance);
+
+    /**
+     * restore the balance after unlink: x took the place of the node that left its
+     * place, moved (nullptr if none) took the place and the balance field of the
+     * unlinked node, removed is the balance field of the node that left its place.
+     */
+    void rebalanceRemove(NodePtr x, NodePtr, int removed, RedBlackBalance) {
+        if (removed == BLACK) {
+            fixDelete(x);
+        }
+    }
+    void rebalanceRemove(NodePtr x, NodePtr, int, AvlBalance) {
+        fixAvl(x->parent());
+    }
+    void rebalanceRemove(NodePtr x, NodePtr, int, WavlBalance) {
+        fixWavlDelete(x, x->parent());
+    }
+    /**
+     * x keeps the heap order, the moved node gets its own priority back.
+     */
+    void rebalanceRemove(NodePtr, NodePtr moved, int removed, TreapBalance) {
+        if (moved != nullptr) {
+            moved->rank(removed);
+            siftDown(moved);
+        }
+    }
+
+    /**
+     * AVL: from z up, recalculate heights and rotate where the heights of the
+     * children differ by 2. Stops at the first node that keeps its height.
+     */
+    void fixAvl(NodePtr z);
+
+    /**
+     * rotations at z whose children heights differ by 2, returns the new root of the subtree.
+     */
+    NodePtr rotateAvl(NodePtr z);
+
+    static void setHeight(NodePtr node) {
+        node->rank(1 + std::max(node->left()->rank(), node->right()->rank()));
+    }
+
+    /**
+     * WAVL: x has the rank of its parent (a 0-child), promote or rotate up the tree.
+     */
+    void fixWavlInsert(NodePtr x);
+
+    /**
+     * WAVL: x (possibly TNIL) under the parent p is a 3-child or p is a 2,2 leaf,
+     * demote or rotate up the tree.
+     */
+    void fixWavlDelete(NodePtr x, NodePtr p);
+
+    /**
+     * treap: rotate the node down while a child has a higher priority.
+     */
+    void siftDown(NodePtr node);
+
+    int nextPriority() {
+        seed_ ^= seed_ << 13;
+        seed_ ^= seed_ >> 7;
+        seed_ ^= seed_ << 17;
+        return static_cast<int>(seed_ >> 33) | 1;
+    }
 
     void rbTransplant(NodePtr u, NodePtr v) {
         if (u->parent() == nullptr) {
@@ -193,11 +472,31 @@ private:
 
     /**
      * remove the key from the tree, starting at root.
+     * The successor node is relinked in place of the removed one, keys never move.
      *
-     * see also https://doxygen.postgresql.org/rbtree_8c_source.html
+     * see also "Introduction to Algorithms", RB-DELETE.
      */
     bool remove(NodePtr root, const Interval& key);
 
+    /**
+     * take the node out of the tree, the node is not freed.
+     */
+    void unlink(NodePtr cursor);
+
+    /**
+     * find the parent for the key, nullptr for the empty tree.
+     * Return TNIL if the key is already in the tree.
+     */
+    NodePtr findParent(const Interval& key) const;
+
+    /**
+     * link the new node under its parent and fix the tree.
+     */
+    void link(NodePtr node);
+
+    template<typename Key>
+    bool insertKey(Key&& key);
+
     /**
      * max(x) = max(rightendpoint(x), max(left(x)), max(right(x)))
      *
@@ -234,6 +533,23 @@ private:
         }
     }
 
+    /**
+     * combine(aggregate(left), value(key), aggregate(right)), TNIL adds identity.
+     */
+    static AggregateValue aggregate(const Interval& key, NodePtr left, NodePtr right) {
+        return Augment::combine(Augment::combine(left == TNIL ? Augment::identity() : left->aggregate(), Augment::value(key)),
+                right == TNIL ? Augment::identity() : right->aggregate());
+    }
+
+    /**
+     * recalculate the augmentation of the node from its children.
+     */
+    static void refresh(NodePtr node) {
+        node->max(max(node->key().end(), node->left(), node->right()));
+        node->min(min(node->key().start(), node->left(), node->right()));
+        node->aggregate(aggregate(node->key(), node->left(), node->right()));
+    }
+
     /**
      *  rotate left at node x
      *
@@ -293,26 +609,365 @@ private:
      */
     static NodePtr predecessor(const NodePtr x);
 
+    /**
+     * check the subtree, returns its black height (rank, 0 for treaps) or -1 if it is broken.
+     */
+    static int blackHeight(const NodePtr node, const NodePtr parent, const Interval* lower, const Interval* upper);
+
+    /**
+     * copy the subtree node by node, colors and augmentation are copied as is.
+     */
+    NodePtr clone(const NodePtr node, NodePtr parent);
+
+    /**
+     * number of black nodes on the path from the node to a leaf, O(height).
+     */
+    int blackHeight(NodePtr node) {
+        int height = 0;
+        for (; node != TNIL; node = node->left()) {
+            height += node->color() == BLACK ? 1 : 0;
+            ++spineSteps_;
+        }
+        return height;
+    }
+
+    /**
+     * the measure of a subtree join needs and the nodes do not keep: the black height
+     * of red-black trees, 0 for the other policies, whose ranks are in the nodes.
+     */
+    int joinHeight(NodePtr node, RedBlackBalance) {
+        return blackHeight(node);
+    }
+    template<typename Tag>
+    int joinHeight(NodePtr, Tag) {
+        return 0;
+    }
+
+    /**
+     * join the detached subtrees left < middle < right, the middle node is linked
+     * between them at the spine of the higher subtree. O(1 + difference of black heights)
+     * given the black heights, of ranks for AVL and WAVL, O(log n) for treaps.
+     * The result becomes root_ and is returned.
+     *
+     * see also "Just Join for Parallel Ordered Sets", G. E. Blelloch, D. Ferizovic, Y. Sun, 2016.
+     */
+    NodePtr join(NodePtr left, NodePtr middle, NodePtr right) {
+        int height;
+        return join(left, joinHeight(left, Balance()), middle, right, joinHeight(right, Balance()), height, Balance());
+    }
+
+    /**
+     * leftHeight and rightHeight - the black heights of the subtrees as they are, a red
+     * root not yet made black; height - the black height of the result.
+     */
+    NodePtr join(NodePtr left, int leftHeight, NodePtr middle, NodePtr right, int rightHeight, int& height, RedBlackBalance);
+    template<typename Tag>
+    NodePtr join(NodePtr left, int, NodePtr middle, NodePtr right, int, int& height, Tag) {
+        height = 0;
+        return join(left, middle, right, Tag());
+    }
+
+    NodePtr join(NodePtr left, NodePtr middle, NodePtr right, AvlBalance);
+    NodePtr join(NodePtr left, NodePtr middle, NodePtr right, WavlBalance);
+    NodePtr join(NodePtr left, NodePtr middle, NodePtr right, TreapBalance);
+
+    /**
+     * link the middle node with the detached subtrees left and right under parent
+     * (as root_ if nullptr), recalculate augmentation up to the root.
+     */
+    void linkMiddle(NodePtr parent, NodePtr middle, NodePtr left, NodePtr right);
+
+    /**
+     * the detached subtree (can be TNIL) becomes a tree on its own: no parent,
+     * the root of a red-black tree is black.
+     */
+    static void detach(NodePtr root, RedBlackBalance) {
+        if (root != TNIL) {
+            root->parent(nullptr);
+            root->color(BLACK);
+        }
+    }
+    template<typename Tag>
+    static void detach(NodePtr root, Tag) {
+        if (root != TNIL) {
+            root->parent(nullptr);
+        }
+    }
+
+    static bool validRoot(NodePtr root, RedBlackBalance) {
+        return root->color() == BLACK;
+    }
+    template<typename Tag>
+    static bool validRoot(NodePtr, Tag) {
+        return true;
+    }
+
+    /**
+     * check the balance of the node given the measures of its children,
+     * returns the measure of the node or -1.
+     */
+    static int balanced(NodePtr node, int left, int right, RedBlackBalance);
+    static int balanced(NodePtr node, int left, int right, AvlBalance);
+    static int balanced(NodePtr node, int left, int right, WavlBalance);
+    static int balanced(NodePtr node, int left, int right, TreapBalance);
+
+    /**
+     * balance field of a node of the built tree at given depth.
+     */
+    static void initBuilt(NodePtr node, int depth, int redDepth, RedBlackBalance) {
+        node->color(depth == redDepth ? RED : BLACK);
+    }
+    static void initBuilt(NodePtr node, int, int, AvlBalance) {
+        setHeight(node);
+    }
+    static void initBuilt(NodePtr node, int, int, WavlBalance) {
+        setHeight(node);
+    }
+    static void initBuilt(NodePtr, int, int, TreapBalance) {
+    }
+
+    /**
+     * priorities of the built treap: random ones sorted and given out level by level.
+     */
+    template<typename Tag>
+    void prioritize(NodePtr, std::size_t, Tag) {
+    }
+    void prioritize(NodePtr root, std::size_t size, TreapBalance);
+
+    /**
+     * join the detached subtrees left < right, the minimum of right is the middle node.
+     */
+    NodePtr join(NodePtr left, NodePtr right);
+
+    /**
+     * split the detached subtree into the intervals starting before at and the rest.
+     * O(log n), the joins along the search path telescope.
+     */
+    void split(NodePtr node, T at, NodePtr& left, NodePtr& right) {
+        int leftHeight, rightHeight;
+        split(node, joinHeight(node, Balance()), at, left, leftHeight, right, rightHeight);
+    }
+
+    /**
+     * height - the black height of the subtree (see joinHeight), the heights of the
+     * children follow from it and the color of the node on the way down, the parts
+     * come back with theirs, so no join walks a spine to find them.
+     */
+    void split(NodePtr node, int height, T at, NodePtr& left, int& leftHeight, NodePtr& right, int& rightHeight);
+
+    /**
+     * free the intervals of the detached subtree ending at or before the watermark,
+     * height - its black height (see joinHeight). Returns the rest, detached, with its
+     * black height in restHeight.
+     */
+    NodePtr expire(NodePtr node, int height, T watermark, int& restHeight, std::size_t& expired);
+
+    /**
+     * link the nodes [first, last), sorted by start, into a balanced detached subtree.
+     * The nodes of the deepest level are RED, all others BLACK, so black heights are equal.
+     * The heights of the halves differ by 1 at most, it is an AVL and WAVL tree too.
+     */
+    static NodePtr build(const PointerVector& nodes, std::size_t first, std::size_t last, NodePtr parent, int depth, int redDepth);
+
+    /**
+     * append the nodes of the subtree to nodes in the order of starts.
+     */
+    void collect(NodePtr node, PointerVector& nodes) const;
+
+    /**
+     * keep the intervals that are in the other tree (common) or are not (!common).
+     */
+    void retain(const IntervalTree& other, bool common);
+
+    /**
+     * balanced detached subtree of all the nodes.
+     */
+    NodePtr build(const PointerVector& nodes) {
+        int redDepth = 0;
+        for (std::size_t n = nodes.size(); n > 1; n /= 2) {
+            ++redDepth;
+        }
+        NodePtr root = build(nodes, 0, nodes.size(), nullptr, 0, redDepth);
+        prioritize(root, nodes.size(), Balance());
+        return root;
+    }
+
+    void steal(IntervalTree& other) {
+        root_ = other.root_;
+        other.root_ = TNIL;
+        ++other.version_;
+        ++modifications_;
+        ++other.modifications_;
+    }
+
+    /**
+     * the allocator moves with the nodes.
+     */
+    void moveAssign(IntervalTree& other, std::true_type) {
+        alloc_ = std::move(other.alloc_);
+        steal(other);
+    }
+
+    /**
+     * the allocator stays, the nodes can be taken only if it can free them.
+     */
+    void moveAssign(IntervalTree& other, std::false_type) {
+        if (alloc_ == other.alloc_) {
+            steal(other);
+        } else {
+            root_ = clone(other.root_, nullptr);
+            ++modifications_;
+            other.clear();
+        }
+    }
+
 public:
 
-    IntervalTree() {
-        root_ = TNIL;
+    typedef Allocator allocator_type;
+
+    IntervalTree() : IntervalTree(Allocator()) {}
+
+    explicit IntervalTree(const Allocator& alloc) : root_(TNIL), alloc_(alloc), version_(0UL), modifications_(0UL),
+            seed_(0x9E3779B97F4A7C15UL), spineSteps_(0UL) {}
+
+    /**
+     * Position of the last search, the next search with the finger starts there
+     * instead of the root. The finger is checked before use: after a node was freed or
+     * moved out of the tree, or with another tree, the search starts from the root.
+     * A finger must not outlive its tree.
+     */
+    class Finger {
+    private:
+        const IntervalTree* tree_;
+        NodePtr node_;
+        unsigned long version_;
+        friend class IntervalTree;
+    public:
+        Finger() : tree_(nullptr), node_(nullptr), version_(0UL) {}
+    };
+
+    /**
+     * Stable reference to an interval in the tree, see find() and overlapSearch().
+     * The node of an interval stays in place while the interval is in the tree
+     * (remove relinks the successor node, keys never move), so a handle is valid
+     * until its interval is removed, moved to another tree by split, join or
+     * mergeFrom, or the tree is cleared or destroyed.
+     */
+    class Handle {
+    private:
+        NodePtr node_;
+        explicit Handle(NodePtr node) : node_(node) {}
+        friend class IntervalTree;
+    public:
+        Handle() : node_(nullptr) {}
+
+        /**
+         * false for the handle of an interval not found.
+         */
+        bool isValid() const {
+            return node_ != nullptr;
+        }
+        const Interval& operator*() const {
+            return node_->key();
+        }
+        const Interval* operator->() const {
+            return &node_->key();
+        }
+        bool operator==(const Handle& other) const {
+            return node_ == other.node_;
+        }
+        bool operator!=(const Handle& other) const {
+            return node_ != other.node_;
+        }
+    };
+
+    /**
+     * Copying is explicit, see clone().
+     */
+    IntervalTree(const IntervalTree&) = delete;
+    IntervalTree& operator=(const IntervalTree&) = delete;
+
+    /**
+     * O(1), the other tree becomes empty.
+     */
+    IntervalTree(IntervalTree&& other) noexcept : root_(other.root_), alloc_(std::move(other.alloc_)), version_(0UL),
+            modifications_(0UL), seed_(other.seed_), spineSteps_(0UL) {
+        other.root_ = TNIL;
+        ++other.version_;
+        ++other.modifications_;
     }
-    ~IntervalTree() {
-        if (!empty()) {
-            delete root_;
+
+    /**
+     * O(1) if the allocator propagates or both allocators are equal,
+     * otherwise the intervals are copied into nodes of this allocator.
+     */
+    IntervalTree& operator=(IntervalTree&& other) noexcept(NodeTraits::propagate_on_container_move_assignment::value) {
+        if (this != &other) {
+            clear();
+            moveAssign(other, typename NodeTraits::propagate_on_container_move_assignment());
         }
+        return *this;
+    }
+
+    ~IntervalTree() {
+        destroy(root_);
+    }
+
+    /**
+     * Duplicate the tree in one linear pass, without inserting and rebalancing.
+     * The copy gets the allocator the way standard containers do on copy.
+     */
+    IntervalTree clone() const {
+        return clone(Allocator(AllocatorTraits::select_on_container_copy_construction(get_allocator())));
+    }
+
+    /**
+     * Duplicate the tree into nodes of the given allocator.
+     */
+    IntervalTree clone(const Allocator& alloc) const {
+        IntervalTree copy(alloc);
+        copy.root_ = copy.clone(root_, nullptr);
+        return copy;
+    }
+
+    allocator_type get_allocator() const {
+        return Allocator(alloc_);
     }
 
     bool empty() const {
         return root_ == TNIL;
     }
 
+    /**
+     * Check order of keys, parent links, balance and augmentation. O(n).
+     */
+    bool isValid() const {
+        return empty() || (root_->parent() == nullptr && validRoot(root_, Balance())
+                && blackHeight(root_, nullptr, nullptr, nullptr) >= 0);
+    }
+
     void clear() {
-        if (!empty()) {
-            delete root_;
-            root_ = TNIL;
-        }
+        destroy(root_);
+        root_ = TNIL;
+        ++modifications_;
+    }
+
+    /**
+     * Changes with every change of the intervals in the tree: insert, remove, updateEnd,
+     * split, join, expire, merge, clear, move. A result computed from the tree stays
+     * correct while the value is the same, see OverlapCache.
+     */
+    unsigned long modifications() const {
+        return modifications_;
+    }
+
+    /**
+     * The number of nodes split and join have walked along spines of subtrees so far,
+     * the part of their cost beyond the search path, e.g. to check that it stays
+     * O(log n).
+     */
+    unsigned long spineSteps() const {
+        return spineSteps_;
     }
 
     /**
@@ -335,6 +990,23 @@ public:
         return search(this->root_, offset);
     }
 
+    /**
+     * Search the tree for the interval with given offset starting at the finger.
+     * The cost is logarithmic in the distance from the previous search,
+     * O(1) amortized for increasing or decreasing offsets close to each other.
+     * The finger moves to the found node or, if there is none, to the last node visited.
+     */
+    const Interval& search(unsigned long offset, Finger& finger) const;
+
+    const Interval& search(const Interval& k, Finger& finger) const {
+        return search(static_cast<unsigned long>(k.start()), finger);
+    }
+
+    /**
+     * The handle of the interval with given offset, not valid if there is none.
+     */
+    Handle find(unsigned long offset) const;
+
     /**
      * Finds in the tree intervals overlapping with the given.
      * The best case (the fastest) - there is no such intervals.
@@ -344,10 +1016,95 @@ public:
         overlapSearch(root_, i, res);
     }
 
+    /**
+     * Appends the intervals overlapping with the given to res in the order of starts.
+     * res is not cleared, a vector reused across calls keeps its capacity and the
+     * search allocates nothing but its stack.
+     */
+    void overlapSearch(const Interval& i, std::vector<Interval>& res) const {
+        orderedOverlapSearch(i, [&res](NodePtr node) {
+            res.push_back(node->key());
+        });
+    }
+
+    /**
+     * Appends pointers to the overlapping intervals in the tree, valid until
+     * the interval is removed.
+     */
+    void overlapSearch(const Interval& i, std::vector<const Interval*>& res) const {
+        orderedOverlapSearch(i, [&res](NodePtr node) {
+            res.push_back(&node->key());
+        });
+    }
+
+    /**
+     * Appends handles of the overlapping intervals, for erase() and updateEnd()
+     * without a second search.
+     */
+    void overlapSearch(const Interval& i, std::vector<Handle>& res) const {
+        orderedOverlapSearch(i, [&res](NodePtr node) {
+            res.push_back(Handle(node));
+        });
+    }
+
+    /**
+     * Finds the overlapping intervals accepted by the augmentation and calls
+     * visit(const Interval&) for them in the order of starts. accept(const value_type&)
+     * tells whether a subtree with the aggregate or an interval with the value can
+     * hold a match, e.g. [p](int priority) { return priority > p; } with MaxPriority;
+     * rejected subtrees are skipped. accept must hold for the aggregate of every
+     * subtree containing an accepted interval.
+     */
+    template<typename Accept, typename Visitor>
+    void overlapSearch(const Interval& i, Accept accept, Visitor visit) const {
+        orderedOverlapSearch(i, [&visit](NodePtr node) {
+            visit(node->key());
+        }, accept);
+    }
+
+    /**
+     * The aggregate of all the intervals, identity for the empty tree.
+     */
+    AggregateValue aggregate() const {
+        return root_ == TNIL ? Augment::identity() : root_->aggregate();
+    }
+
+    /**
+     * Finds the intervals overlapping with each query of the range and calls
+     * visit(std::size_t query, const Interval&), query is the position in the range.
+     * Up to group searches run in turns, each step of a search prefetches the nodes
+     * of its next steps, so the cache misses of different searches overlap.
+     * Pays off for trees larger than the last level cache.
+     */
+    template<typename Iterator, typename Visitor>
+    void batchOverlapSearch(Iterator first, Iterator last, Visitor visit, std::size_t group = 16) const;
+
+    /**
+     * Call visit(const Interval&) for each interval in the order of starts.
+     */
+    template<typename Visitor>
+    void forEach(Visitor visit) const;
+
     /**
      *  insert the key to the tree in its appropriate position and fix the tree
      */
-    bool insert(const Interval& key);
+    bool insert(const Interval& key) {
+        return insertKey(key);
+    }
+
+    /**
+     * insert moving the key into the node.
+     */
+    bool insert(Interval&& key) {
+        return insertKey(std::move(key));
+    }
+
+    /**
+     * construct the interval in the node from args and insert it.
+     * If the interval is already in the tree the new node is freed and false returned.
+     */
+    template<typename... Args>
+    bool emplace(Args&&... args);
 
     /**
      * delete the node from the tree
@@ -356,51 +1113,127 @@ public:
         return remove(this->root_, key);
     }
 
-    friend class HierarchyWriter<T, Interval>;
-    friend class SequenceWriter<T, Interval>;
+    /**
+     * Remove the interval of the handle, which must belong to this tree.
+     * No search, O(log n) for the rebalancing only.
+     */
+    void erase(Handle handle) {
+        unlink(handle.node_);
+        destroyNode(handle.node_);
+    }
+
+    /**
+     * Change the end of the interval of the handle in place, e.g. an extent growing
+     * with appends. The start and so the position in the tree stay, only max of the
+     * ancestors is refreshed, up to the first one that does not change: no removal,
+     * no insertion, no rotations. The interval is rebuilt with Interval::valueOf(start, end),
+     * which throws std::invalid_argument for end < start.
+     */
+    void updateEnd(Handle handle, T end);
+
+    /**
+     * Remove all intervals with end <= watermark, returns their number.
+     * For a sliding window over a stream, Augment must be MinEndAugmentation<T> (or derive
+     * from it): only the subtrees holding an expired interval are taken apart, all
+     * others are joined back whole, the expired nodes are freed without rebalancing
+     * the tree per interval. O(log n + k log(n / k + 1)), k - the expired intervals,
+     * whatever the number of the live ones; O(1) if nothing expires.
+     */
+    std::size_t expireBefore(T watermark);
+
+    /**
+     * Move the intervals starting at or after at into the returned tree,
+     * the intervals starting before at stay. O(log n).
+     */
+    IntervalTree split(T at);
+
+    /**
+     * Concatenate the trees, all intervals of left must start before all intervals
+     * of right, std::invalid_argument is thrown otherwise. Both trees become empty.
+     * O(log n); the nodes of right are copied if the allocators are not equal.
+     */
+    static IntervalTree join(IntervalTree&& left, IntervalTree&& right);
+
+    /**
+     * Union: move the intervals of the other tree into this one, the other tree
+     * becomes empty. Of two intervals with the same start the one of this tree stays.
+     * The in-order sequences are merged and the nodes relinked into a balanced tree,
+     * O(n + m) instead of m insertions. The nodes of the other tree are copied if the
+     * allocators are not equal.
+     */
+    void mergeFrom(IntervalTree&& other);
+
+    /**
+     * Intersection: keep only the intervals equal to an interval of the other tree
+     * (operator==, the same start with interval_operations.hpp). O(n + m).
+     */
+    void intersectWith(const IntervalTree& other) {
+        retain(other, true);
+    }
+
+    /**
+     * Difference: remove the intervals equal to an interval of the other tree. O(n + m).
+     */
+    void subtract(const IntervalTree& other) {
+        retain(other, false);
+    }
+
+    template<typename, typename, typename>
+    friend class HierarchyWriter;
+    template<typename, typename, typename>
+    friend class SequenceWriter;
 };
 
+#if __cplusplus >= 201703L
 /**
- * writes the tree structure to text file.
+ * IntervalTree allocating from a std::pmr::memory_resource, e.g. a per-request
+ * std::pmr::monotonic_buffer_resource released at once with the request.
  */
 template<typename T, typename Interval = IntervalT<T>>
+using PmrIntervalTree = IntervalTree<T, Interval, std::pmr::polymorphic_allocator<Interval>>;
+#endif
+
+/**
+ * writes the tree structure to text file.
+ */
+template<typename T, typename Interval = IntervalT<T>, typename Tree = IntervalTree<T, Interval>>
 class HierarchyWriter {
 private:
-    const IntervalTree<T, Interval>& tree;
+    const Tree& tree;
 
-    std::ostream& print(std::ostream& os, const typename IntervalTree<T, Interval>::NodePtr root, std::string indent, bool last) const;
+    std::ostream& print(std::ostream& os, const typename Tree::NodePtr root, std::string indent, bool last) const;
 public:
-    HierarchyWriter(const IntervalTree<T, Interval>& t) : tree(t) {}
+    HierarchyWriter(const Tree& t) : tree(t) {}
 
     std::ostream& print(std::ostream& os) const {
         return print(os, tree.root_, "", true);
     }
 };
 
-template<typename T, typename Interval = IntervalT<T>>
-inline std::ostream& operator << (std::ostream& os, const HierarchyWriter<T, Interval>& prnt) {
+template<typename T, typename Interval, typename Tree>
+inline std::ostream& operator << (std::ostream& os, const HierarchyWriter<T, Interval, Tree>& prnt) {
    return prnt.print(os);
 }
 
 /**
  * writes a sequence of intervals to text file.
  */
-template<typename T, typename Interval = IntervalT<T>>
+template<typename T, typename Interval = IntervalT<T>, typename Tree = IntervalTree<T, Interval>>
 class SequenceWriter {
 private:
-   const IntervalTree<T, Interval>& tree;
+   const Tree& tree;
 
-   std::ostream& print(std::ostream& os, const typename IntervalTree<T, Interval>::NodePtr root) const;
+   std::ostream& print(std::ostream& os, const typename Tree::NodePtr root) const;
 public:
-   SequenceWriter(const IntervalTree<T, Interval>& t) : tree(t) {}
+   SequenceWriter(const Tree& t) : tree(t) {}
 
    std::ostream& print(std::ostream& os) const {
        return print(os, tree.root_);
    }
 };
 
-template<typename T, typename Interval = IntervalT<T>>
-inline std::ostream& operator << (std::ostream& os, const SequenceWriter<T, Interval>& prnt) {
+template<typename T, typename Interval, typename Tree>
+inline std::ostream& operator << (std::ostream& os, const SequenceWriter<T, Interval, Tree>& prnt) {
    return prnt.print(os);
 }
 
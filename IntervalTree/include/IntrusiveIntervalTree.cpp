@@ -0,0 +1,327 @@
+#ifndef INTRUSIVE_INTERVAL_TREE_CPP
+#define INTRUSIVE_INTERVAL_TREE_CPP
+
+template<typename T, typename Item>
+void IntrusiveIntervalTree<T, Item>::augmentation(Item* item, T& max, T& min) {
+    const Hook& h = hook(item);
+    T high = item->end(), low = item->start();
+    if (h.left_ != nullptr) {
+        high = std::max(high, hook(h.left_).max_);
+        low = std::min(low, hook(h.left_).min_);
+    }
+    if (h.right_ != nullptr) {
+        high = std::max(high, hook(h.right_).max_);
+        low = std::min(low, hook(h.right_).min_);
+    }
+    max = high;
+    min = low;
+}
+
+/**
+ * Only x and y change their subtrees, the ancestors keep the same items,
+ * so their max and min stay.
+ */
+template<typename T, typename Item>
+void IntrusiveIntervalTree<T, Item>::rotateLeft(Item* x) {
+    Item* y = hook(x).right_;
+    hook(x).right_ = hook(y).left_;
+    if (hook(y).left_ != nullptr) {
+        hook(hook(y).left_).parent_ = x;
+    }
+    transplant(x, y);
+    hook(y).left_ = x;
+    hook(x).parent_ = y;
+    update(x);
+    update(y);
+}
+
+template<typename T, typename Item>
+void IntrusiveIntervalTree<T, Item>::rotateRight(Item* x) {
+    Item* y = hook(x).left_;
+    hook(x).left_ = hook(y).right_;
+    if (hook(y).right_ != nullptr) {
+        hook(hook(y).right_).parent_ = x;
+    }
+    transplant(x, y);
+    hook(y).right_ = x;
+    hook(x).parent_ = y;
+    update(x);
+    update(y);
+}
+
+/**
+ * v takes the place of u under the parent of u, v can be nullptr.
+ */
+template<typename T, typename Item>
+void IntrusiveIntervalTree<T, Item>::transplant(Item* u, Item* v) {
+    Item* parent = hook(u).parent_;
+    if (parent == nullptr) {
+        root_ = v;
+    } else if (u == hook(parent).left_) {
+        hook(parent).left_ = v;
+    } else {
+        hook(parent).right_ = v;
+    }
+    if (v != nullptr) {
+        hook(v).parent_ = parent;
+    }
+}
+
+template<typename T, typename Item>
+void IntrusiveIntervalTree<T, Item>::fixInsert(Item* k) {
+    while (isRed(hook(k).parent_)) {
+        Item* parent = hook(k).parent_;
+        Item* grand = hook(parent).parent_;
+        if (parent == hook(grand).left_) {
+            Item* uncle = hook(grand).right_;
+            if (isRed(uncle)) {
+                hook(uncle).red_ = false;
+                hook(parent).red_ = false;
+                hook(grand).red_ = true;
+                k = grand;
+            } else {
+                if (k == hook(parent).right_) {
+                    k = parent;
+                    rotateLeft(k);
+                    parent = hook(k).parent_;
+                }
+                hook(parent).red_ = false;
+                hook(grand).red_ = true;
+                rotateRight(grand);
+            }
+        } else {
+            Item* uncle = hook(grand).left_;
+            if (isRed(uncle)) {
+                hook(uncle).red_ = false;
+                hook(parent).red_ = false;
+                hook(grand).red_ = true;
+                k = grand;
+            } else {
+                if (k == hook(parent).left_) {
+                    k = parent;
+                    rotateRight(k);
+                    parent = hook(k).parent_;
+                }
+                hook(parent).red_ = false;
+                hook(grand).red_ = true;
+                rotateLeft(grand);
+            }
+        }
+    }
+    hook(root_).red_ = false;
+}
+
+/**
+ * x carries an extra black. When x is nullptr the sibling is not: the removed black
+ * item left a black height of at least one on the other side, so x == left of parent
+ * tells the sides apart even for a nullptr x.
+ */
+template<typename T, typename Item>
+void IntrusiveIntervalTree<T, Item>::fixDelete(Item* x, Item* parent) {
+    while (x != root_ && !isRed(x)) {
+        if (x == hook(parent).left_) {
+            Item* w = hook(parent).right_;
+            if (isRed(w)) {
+                hook(w).red_ = false;
+                hook(parent).red_ = true;
+                rotateLeft(parent);
+                w = hook(parent).right_;
+            }
+            if (!isRed(hook(w).left_) && !isRed(hook(w).right_)) {
+                hook(w).red_ = true;
+                x = parent;
+                parent = hook(x).parent_;
+            } else {
+                if (!isRed(hook(w).right_)) {
+                    hook(hook(w).left_).red_ = false;
+                    hook(w).red_ = true;
+                    rotateRight(w);
+                    w = hook(parent).right_;
+                }
+                hook(w).red_ = hook(parent).red_;
+                hook(parent).red_ = false;
+                hook(hook(w).right_).red_ = false;
+                rotateLeft(parent);
+                x = root_;
+            }
+        } else {
+            Item* w = hook(parent).left_;
+            if (isRed(w)) {
+                hook(w).red_ = false;
+                hook(parent).red_ = true;
+                rotateRight(parent);
+                w = hook(parent).left_;
+            }
+            if (!isRed(hook(w).left_) && !isRed(hook(w).right_)) {
+                hook(w).red_ = true;
+                x = parent;
+                parent = hook(x).parent_;
+            } else {
+                if (!isRed(hook(w).left_)) {
+                    hook(hook(w).right_).red_ = false;
+                    hook(w).red_ = true;
+                    rotateLeft(w);
+                    w = hook(parent).left_;
+                }
+                hook(w).red_ = hook(parent).red_;
+                hook(parent).red_ = false;
+                hook(hook(w).left_).red_ = false;
+                rotateRight(parent);
+                x = root_;
+            }
+        }
+    }
+    if (x != nullptr) {
+        hook(x).red_ = false;
+    }
+}
+
+template<typename T, typename Item>
+template<typename Interval>
+void IntrusiveIntervalTree<T, Item>::overlapSearch(Item* item, const Interval& i, std::vector<Item*>& res) {
+    if (item == nullptr || !(i.start() < hook(item).max_)) {
+        return;
+    }
+    overlapSearch(hook(item).left_, i, res);
+    if (!(item->start() < i.end())) {
+        return;
+    }
+    if (i.start() < item->end()) {
+        res.push_back(item);
+    }
+    Item* right = hook(item).right_;
+    if (right != nullptr && hook(right).min_ < i.end()) {
+        overlapSearch(right, i, res);
+    }
+}
+
+template<typename T, typename Item>
+template<typename Visitor>
+void IntrusiveIntervalTree<T, Item>::forEach(Item* item, Visitor& visit) {
+    while (item != nullptr) {
+        forEach(hook(item).left_, visit);
+        visit(*item);
+        item = hook(item).right_;
+    }
+}
+
+template<typename T, typename Item>
+int IntrusiveIntervalTree<T, Item>::blackHeight(Item* item, Item* parent, const Item* lower, const Item* upper) {
+    if (item == nullptr) {
+        return 1;
+    }
+    const Hook& h = hook(item);
+    if (h.parent_ != parent || (lower != nullptr && !(lower->start() < item->start()))
+            || (upper != nullptr && !(item->start() < upper->start()))
+            || (h.red_ && isRed(parent))) {
+        return -1;
+    }
+    T max, min;
+    augmentation(item, max, min);
+    if (max != h.max_ || min != h.min_) {
+        return -1;
+    }
+    int left = blackHeight(h.left_, item, lower, item);
+    int right = blackHeight(h.right_, item, item, upper);
+    if (left < 0 || left != right) {
+        return -1;
+    }
+    return left + (h.red_ ? 0 : 1);
+}
+
+template<typename T, typename Item>
+Item* IntrusiveIntervalTree<T, Item>::search(T offset) const {
+    Item* item = root_;
+    while (item != nullptr) {
+        if (offset < item->start()) {
+            item = hook(item).left_;
+        } else if (item->start() < offset) {
+            item = hook(item).right_;
+        } else {
+            return item;
+        }
+    }
+    return nullptr;
+}
+
+template<typename T, typename Item>
+bool IntrusiveIntervalTree<T, Item>::insert(Item& item) {
+    Item* parent = nullptr;
+    Item* curr = root_;
+    while (curr != nullptr) {
+        parent = curr;
+        if (item.start() < curr->start()) {
+            curr = hook(curr).left_;
+        } else if (curr->start() < item.start()) {
+            curr = hook(curr).right_;
+        } else {
+            return false;
+        }
+    }
+    Hook& h = hook(&item);
+    h.parent_ = parent;
+    h.left_ = nullptr;
+    h.right_ = nullptr;
+    h.red_ = true;
+    update(&item);
+    if (parent == nullptr) {
+        root_ = &item;
+    } else if (item.start() < parent->start()) {
+        hook(parent).left_ = &item;
+    } else {
+        hook(parent).right_ = &item;
+    }
+    for (Item* p = parent; p != nullptr; p = hook(p).parent_) {
+        update(p);
+    }
+    fixInsert(&item);
+    return true;
+}
+
+/**
+ * CLRS delete. The item moved into the place of z (if any) lies on the path
+ * from the parent of x to the root, so one walk up refreshes max and min.
+ */
+template<typename T, typename Item>
+void IntrusiveIntervalTree<T, Item>::remove(Item& item) {
+    Item* z = &item;
+    bool removedRed = hook(z).red_;
+    Item* x;
+    Item* parent;
+    if (hook(z).left_ == nullptr) {
+        x = hook(z).right_;
+        parent = hook(z).parent_;
+        transplant(z, x);
+    } else if (hook(z).right_ == nullptr) {
+        x = hook(z).left_;
+        parent = hook(z).parent_;
+        transplant(z, x);
+    } else {
+        Item* y = minimum(hook(z).right_);
+        removedRed = hook(y).red_;
+        x = hook(y).right_;
+        if (hook(y).parent_ == z) {
+            parent = y;
+        } else {
+            parent = hook(y).parent_;
+            transplant(y, x);
+            hook(y).right_ = hook(z).right_;
+            hook(hook(y).right_).parent_ = y;
+        }
+        transplant(z, y);
+        hook(y).left_ = hook(z).left_;
+        hook(hook(y).left_).parent_ = y;
+        hook(y).red_ = hook(z).red_;
+    }
+    for (Item* p = parent; p != nullptr; p = hook(p).parent_) {
+        update(p);
+    }
+    if (!removedRed) {
+        fixDelete(x, parent);
+    }
+    hook(z).parent_ = nullptr;
+    hook(z).left_ = nullptr;
+    hook(z).right_ = nullptr;
+}
+
+#endif /* INTRUSIVE_INTERVAL_TREE_CPP */
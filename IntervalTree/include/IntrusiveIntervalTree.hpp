@@ -0,0 +1,195 @@
+/*
+ * IntrusiveIntervalTree.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: andrei
+ */
+
+#ifndef INTRUSIVEINTERVALTREE_HPP_
+#define INTRUSIVEINTERVALTREE_HPP_
+
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <type_traits>
+
+template<typename T, typename Item>
+class IntrusiveIntervalTree;
+
+/**
+ * Links of an item in IntrusiveIntervalTree, the item derives from the hook publicly:
+ *
+ *   struct Extent: IntrusiveIntervalHook<unsigned long, Extent> {
+ *       unsigned long start() const;
+ *       unsigned long end() const;
+ *   };
+ *
+ * Copying an item does not copy its links, the copy is not in a tree.
+ */
+template<typename T, typename Item>
+class IntrusiveIntervalHook {
+private:
+    Item* parent_;
+    Item* left_;
+    Item* right_;
+    /**
+     * maximal right endpoint and minimal left endpoint in the subtree of the item.
+     */
+    T max_;
+    T min_;
+    bool red_;
+
+    template<typename, typename>
+    friend class IntrusiveIntervalTree;
+
+public:
+    IntrusiveIntervalHook() : parent_(nullptr), left_(nullptr), right_(nullptr), max_(), min_(), red_(false) {}
+
+    IntrusiveIntervalHook(const IntrusiveIntervalHook&) : IntrusiveIntervalHook() {}
+
+    IntrusiveIntervalHook& operator=(const IntrusiveIntervalHook&) {
+        return *this;
+    }
+};
+
+/**
+ * Interval tree linking the items of the user, the items embed the links
+ * (IntrusiveIntervalHook) and stay where the user keeps them, e.g. in a slab.
+ * insert and remove never allocate, queries return pointers to the items.
+ * The tree does not own the items: an item must stay alive and keep its start and
+ * end while it is in the tree, clear() and the destructor only drop the links.
+ *
+ * The same red-black tree with max/min augmentation as IntervalTree, starts are unique.
+ * Leaves are nullptr, there is no sentinel item.
+ */
+template<typename T, typename Item>
+class IntrusiveIntervalTree {
+private:
+    typedef IntrusiveIntervalHook<T, Item> Hook;
+
+    Item* root_;
+
+    static Hook& hook(Item* item) {
+        static_assert(std::is_base_of<Hook, Item>::value, "Item must derive from IntrusiveIntervalHook<T, Item>");
+        return *item;
+    }
+
+    static bool isRed(Item* item) {
+        return item != nullptr && hook(item).red_;
+    }
+
+    /**
+     * max and min of the item as they follow from its children, nothing is written.
+     */
+    static void augmentation(Item* item, T& max, T& min);
+
+    /**
+     * recalculate max and min of the item from its children.
+     */
+    static void update(Item* item) {
+        augmentation(item, hook(item).max_, hook(item).min_);
+    }
+
+    void rotateLeft(Item* x);
+    void rotateRight(Item* x);
+
+    void transplant(Item* u, Item* v);
+
+    void fixInsert(Item* k);
+
+    /**
+     * x can be nullptr, so its parent is passed along.
+     */
+    void fixDelete(Item* x, Item* parent);
+
+    static Item* minimum(Item* item) {
+        while (hook(item).left_ != nullptr) {
+            item = hook(item).left_;
+        }
+        return item;
+    }
+
+    template<typename Interval>
+    static void overlapSearch(Item* item, const Interval& i, std::vector<Item*>& res);
+
+    template<typename Visitor>
+    static void forEach(Item* item, Visitor& visit);
+
+    /**
+     * check the subtree, returns its black height or -1 if it is broken.
+     */
+    static int blackHeight(Item* item, Item* parent, const Item* lower, const Item* upper);
+
+public:
+    IntrusiveIntervalTree() : root_(nullptr) {}
+
+    IntrusiveIntervalTree(const IntrusiveIntervalTree&) = delete;
+    IntrusiveIntervalTree& operator=(const IntrusiveIntervalTree&) = delete;
+
+    IntrusiveIntervalTree(IntrusiveIntervalTree&& other) noexcept : root_(other.root_) {
+        other.root_ = nullptr;
+    }
+
+    IntrusiveIntervalTree& operator=(IntrusiveIntervalTree&& other) noexcept {
+        if (this != &other) {
+            root_ = other.root_;
+            other.root_ = nullptr;
+        }
+        return *this;
+    }
+
+    bool empty() const {
+        return root_ == nullptr;
+    }
+
+    /**
+     * Unlink all items, O(1). The items keep stale links until inserted again.
+     */
+    void clear() {
+        root_ = nullptr;
+    }
+
+    /**
+     * Check order, parent links, red-black properties and augmentation. O(n).
+     */
+    bool isValid() const {
+        return empty() || (hook(root_).parent_ == nullptr && !isRed(root_)
+                && blackHeight(root_, nullptr, nullptr, nullptr) >= 0);
+    }
+
+    /**
+     * The item with given offset, nullptr if there is none.
+     */
+    Item* search(T offset) const;
+
+    /**
+     * Appends the items overlapping with the interval i (anything with start() and end())
+     * to res in the order of starts. Recursive, the depth is the height of the tree.
+     */
+    template<typename Interval>
+    void overlapSearch(const Interval& i, std::vector<Item*>& res) const {
+        overlapSearch(root_, i, res);
+    }
+
+    /**
+     * Call visit(Item&) for each item in the order of starts.
+     */
+    template<typename Visitor>
+    void forEach(Visitor visit) const {
+        forEach(root_, visit);
+    }
+
+    /**
+     * Link the item, false if an item with the same start is already in the tree.
+     */
+    bool insert(Item& item);
+
+    /**
+     * Unlink the item, which must be in this tree. No search: the item is its node.
+     */
+    void remove(Item& item);
+};
+
+#include "IntrusiveIntervalTree.cpp"
+
+#endif /* INTRUSIVEINTERVALTREE_HPP_ */
@@ -0,0 +1,193 @@
+/*
+ * NestedContainmentList.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: andrei
+ */
+
+#ifndef NESTEDCONTAINMENTLIST_HPP_
+#define NESTEDCONTAINMENTLIST_HPP_
+
+#include <iostream>
+#include <algorithm>
+#include <set>
+#include <vector>
+#include <utility>
+
+#include <Interval.hpp>
+#include <IntervalTree.hpp>
+
+/**
+ * Nested Containment List, static index for immutable sets of intervals.
+ *
+ * The intervals are split into lists: the top list holds the intervals not contained
+ * in any other interval, each interval owns the list of intervals directly contained in it.
+ * Inside a list neither interval contains another, so both starts and ends grow and the
+ * intervals overlapping a query form one contiguous run found by binary search.
+ * A long enclosing interval does not weaken the search in its siblings, as it does
+ * with the max_ augmentation of IntervalTree.
+ *
+ * All lists are stored in one array, the sublist of an interval is a contiguous range of it.
+ *
+ * see also "Nested Containment List (NCList): a new algorithm for accelerating interval
+ * query of genome alignment and interval databases", A. V. Alekseyenko, C. J. Lee, 2007.
+ */
+template<typename T, typename Interval = IntervalT<T>>
+class NestedContainmentList {
+private:
+    /**
+     * intervals grouped by lists, sorted by start inside a list.
+     */
+    std::vector<Interval> keys_;
+    /**
+     * ends of keys_, binary search in a list runs over them.
+     */
+    std::vector<T> ends_;
+    /**
+     * the sublist of keys_[i] is [begin_[i], end_[i]), see build().
+     */
+    std::vector<std::size_t> begin_;
+    std::vector<std::size_t> end_;
+    /**
+     * the top list is [0, top_).
+     */
+    std::size_t top_;
+
+    /**
+     * start ascending, the enclosing interval first for equal starts.
+     */
+    static bool containmentOrder(const Interval& i1, const Interval& i2) {
+        return i1.start() < i2.start() || (i1.start() == i2.start() && i1.end() > i2.end());
+    }
+
+    /**
+     * sorted contains intervals in containmentOrder.
+     */
+    void build(const std::vector<Interval>& sorted);
+
+    std::size_t firstEndingAfter(std::size_t first, std::size_t last, T point) const {
+        return std::upper_bound(ends_.begin() + first, ends_.begin() + last, point) - ends_.begin();
+    }
+
+    void overlapSearch(std::size_t first, std::size_t last, const Interval& i, std::set<Interval>& res) const;
+
+public:
+    /**
+     * Index the range of intervals, the range does not need to be sorted.
+     */
+    template<typename Iterator>
+    NestedContainmentList(Iterator first, Iterator last) : top_(0) {
+        std::vector<Interval> sorted(first, last);
+        if (!std::is_sorted(sorted.begin(), sorted.end(), containmentOrder)) {
+            std::sort(sorted.begin(), sorted.end(), containmentOrder);
+        }
+        build(sorted);
+    }
+
+    /**
+     * Index the content of the tree, the tree already holds the intervals sorted.
+     */
+    template<typename... TreeArgs>
+    explicit NestedContainmentList(const IntervalTree<T, Interval, TreeArgs...>& tree) : top_(0) {
+        std::vector<Interval> sorted;
+        tree.forEach([&sorted](const Interval& i) {
+            sorted.push_back(i);
+        });
+        build(sorted);
+    }
+
+    bool empty() const {
+        return keys_.empty();
+    }
+
+    std::size_t size() const {
+        return keys_.size();
+    }
+
+    /**
+     * Finds intervals overlapping with the given.
+     */
+    void overlapSearch(const Interval& i, std::set<Interval>& res) const {
+        overlapSearch(0, top_, i, res);
+    }
+};
+
+/**
+ * Each interval is nested into the closest preceding interval that contains it,
+ * the stack holds the chain of enclosing intervals of the current one.
+ * Then every list gets a contiguous block: the top list first, then the sublists
+ * in the sorted order of their owners.
+ */
+template<typename T, typename Interval>
+void NestedContainmentList<T, Interval>::build(const std::vector<Interval>& sorted) {
+    const std::size_t n = sorted.size();
+    const std::size_t none = n;
+
+    std::vector<std::size_t> parent(n, none);
+    std::vector<std::size_t> children(n + 1, 0);
+    std::vector<std::size_t> stack;
+    for (std::size_t i = 0; i < n; ++i) {
+        while (!stack.empty() && sorted[stack.back()].end() < sorted[i].end()) {
+            stack.pop_back();
+        }
+        parent[i] = stack.empty() ? none : stack.back();
+        ++children[parent[i]];
+        stack.push_back(i);
+    }
+
+    /*
+     * blocks[p] - the first slot of the list owned by p, blocks[none] - the top list.
+     */
+    std::vector<std::size_t> blocks(n + 1, 0);
+    std::size_t next = children[none];
+    for (std::size_t i = 0; i < n; ++i) {
+        blocks[i] = next;
+        next += children[i];
+    }
+    top_ = children[none];
+
+    keys_.resize(n);
+    ends_.resize(n);
+    begin_.resize(n);
+    end_.resize(n);
+    std::vector<std::size_t> filled(n + 1, 0);
+    for (std::size_t i = 0; i < n; ++i) {
+        std::size_t pos = blocks[parent[i]] + filled[parent[i]]++;
+        keys_[pos] = sorted[i];
+        ends_[pos] = sorted[i].end();
+        begin_[pos] = blocks[i];
+        end_[pos] = blocks[i] + children[i];
+    }
+}
+
+/**
+ * In a list ends grow with starts: skip the intervals ending before the query by
+ * binary search, report the following ones while they start before the query end.
+ * Nesting can be as deep as the number of intervals, so the lists being scanned
+ * are kept on an explicit stack.
+ */
+template<typename T, typename Interval>
+void NestedContainmentList<T, Interval>::overlapSearch(std::size_t first, std::size_t last, const Interval& i, std::set<Interval>& res) const {
+    /*
+     * the next interval to check and the end of its list.
+     */
+    std::vector<std::pair<std::size_t, std::size_t>> s;
+    s.push_back(std::make_pair(firstEndingAfter(first, last, i.start()), last));
+    while (!s.empty()) {
+        std::size_t k = s.back().first;
+        last = s.back().second;
+        if (k == last || !(keys_[k].start() < i.end())) {
+            s.pop_back();
+            continue;
+        }
+        ++s.back().first;
+        if (overlap(keys_[k], i)) {
+            res.insert(keys_[k]);
+        }
+        if (begin_[k] != end_[k]) {
+            s.push_back(std::make_pair(firstEndingAfter(begin_[k], end_[k], i.start()), end_[k]));
+        }
+    }
+}
+
+#endif /* NESTEDCONTAINMENTLIST_HPP_ */
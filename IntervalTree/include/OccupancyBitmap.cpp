@@ -0,0 +1,86 @@
+#ifndef OCCUPANCY_BITMAP_CPP
+#define OCCUPANCY_BITMAP_CPP
+
+template<typename T, typename Interval>
+OccupancyBitmap<T, Interval>::OccupancyBitmap(T origin, T width, std::size_t buckets) : origin_(origin), width_(width) {
+    if (!(T() < width) || buckets == 0) {
+        throw std::invalid_argument("OccupancyBitmap: width and buckets must be positive");
+    }
+    counts_.assign(buckets, 0UL);
+    bits_.assign((buckets + WORD_BITS - 1) / WORD_BITS, 0ULL);
+}
+
+template<typename T, typename Interval>
+std::size_t OccupancyBitmap<T, Interval>::bucket(T point) const {
+    if (point < origin_) {
+        return 0;
+    }
+    T index = (point - origin_) / width_;
+    T last = static_cast<T>(counts_.size() - 1);
+    return last < index ? counts_.size() - 1 : static_cast<std::size_t>(index);
+}
+
+template<typename T, typename Interval>
+bool OccupancyBitmap<T, Interval>::empty() const {
+    for (auto word: bits_) {
+        if (word != 0ULL) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename T, typename Interval>
+void OccupancyBitmap<T, Interval>::insert(const Interval& i) {
+    std::size_t first, last;
+    range(i, first, last);
+    for (std::size_t b = first; b <= last; ++b) {
+        if (counts_[b]++ == 0UL) {
+            bits_[b / WORD_BITS] |= 1ULL << (b % WORD_BITS);
+        }
+    }
+}
+
+template<typename T, typename Interval>
+bool OccupancyBitmap<T, Interval>::remove(const Interval& i) {
+    std::size_t first, last;
+    range(i, first, last);
+    for (std::size_t b = first; b <= last; ++b) {
+        if (counts_[b] == 0UL) {
+            return false;
+        }
+    }
+    for (std::size_t b = first; b <= last; ++b) {
+        if (--counts_[b] == 0UL) {
+            bits_[b / WORD_BITS] &= ~(1ULL << (b % WORD_BITS));
+        }
+    }
+    return true;
+}
+
+/**
+ * The words of the buckets [first, last] are tested whole, the first and the last
+ * one under a mask, so a window of k buckets reads k / 64 + 2 words at most.
+ */
+template<typename T, typename Interval>
+bool OccupancyBitmap<T, Interval>::mayOverlap(const Interval& window) const {
+    std::size_t first, last;
+    range(window, first, last);
+    std::size_t firstWord = first / WORD_BITS, lastWord = last / WORD_BITS;
+    unsigned long long head = ~0ULL << (first % WORD_BITS);
+    unsigned long long tail = ~0ULL >> (WORD_BITS - 1 - last % WORD_BITS);
+    if (firstWord == lastWord) {
+        return (bits_[firstWord] & head & tail) != 0ULL;
+    }
+    if ((bits_[firstWord] & head) != 0ULL || (bits_[lastWord] & tail) != 0ULL) {
+        return true;
+    }
+    for (std::size_t w = firstWord + 1; w < lastWord; ++w) {
+        if (bits_[w] != 0ULL) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif /* OCCUPANCY_BITMAP_CPP */
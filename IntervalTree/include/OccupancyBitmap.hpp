@@ -0,0 +1,106 @@
+/*
+ * OccupancyBitmap.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: andrei
+ */
+
+#ifndef OCCUPANCYBITMAP_HPP_
+#define OCCUPANCYBITMAP_HPP_
+
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <stdexcept>
+#include <type_traits>
+
+#include <Interval.hpp>
+
+/**
+ * Coarse prefilter of overlap queries: the coordinate space is cut into buckets of
+ * equal width, a bucket counts the intervals touching it and one bit per bucket tells
+ * whether the count is above zero. Kept alongside IntervalTree, an interval is inserted
+ * into (removed from) both, and a query goes to the tree only if mayOverlap:
+ *
+ *   if (occupancy.mayOverlap(window)) {
+ *       tree.overlapSearch(window, res);
+ *   }
+ *
+ * mayOverlap never misses an overlap, it can only report one for a window sharing
+ * a bucket with an interval, so empty regions wider than a bucket are answered from
+ * a few words of the bitmap without touching tree nodes.
+ *
+ * An interval [start, end) touches the buckets from the one of start to the one of
+ * the last point before end, an empty interval the bucket of its start, as it overlaps
+ * the windows containing the start. Coordinates before the origin fall into the first
+ * bucket, after the last bucket into the last one. Insert and remove are O(buckets
+ * touched): the bucket width should be about the length of typical intervals.
+ */
+template<typename T, typename Interval = IntervalT<T>>
+class OccupancyBitmap {
+private:
+    static const std::size_t WORD_BITS = 64;
+
+    T origin_;
+    T width_;
+    /**
+     * number of intervals touching each bucket.
+     */
+    std::vector<unsigned long> counts_;
+    /**
+     * bit b % 64 of word b / 64 is set if counts_[b] > 0.
+     */
+    std::vector<unsigned long long> bits_;
+
+    std::size_t bucket(T point) const;
+
+    /**
+     * the buckets [first, last] an interval or a window touches. The last point before
+     * the end is end - 1 for integers, for other types the bucket of the end is taken,
+     * one bucket more at most.
+     */
+    void range(const Interval& i, std::size_t& first, std::size_t& last) const {
+        first = bucket(i.start());
+        last = i.start() < i.end() ? bucket(std::is_integral<T>::value ? i.end() - 1 : i.end()) : first;
+    }
+
+public:
+    /**
+     * buckets of given width from the origin on, width > 0 and buckets > 0.
+     */
+    OccupancyBitmap(T origin, T width, std::size_t buckets);
+
+    std::size_t buckets() const {
+        return counts_.size();
+    }
+
+    /**
+     * no interval is counted.
+     */
+    bool empty() const;
+
+    void clear() {
+        std::fill(counts_.begin(), counts_.end(), 0UL);
+        std::fill(bits_.begin(), bits_.end(), 0ULL);
+    }
+
+    /**
+     * Count the interval in the buckets it touches, the same interval can be counted many times.
+     */
+    void insert(const Interval& i);
+
+    /**
+     * Take away one count of an inserted interval.
+     * false (and nothing changes) if a bucket of the interval has no count.
+     */
+    bool remove(const Interval& i);
+
+    /**
+     * false if no counted interval overlaps the window, true if one might.
+     */
+    bool mayOverlap(const Interval& window) const;
+};
+
+#include "OccupancyBitmap.cpp"
+
+#endif /* OCCUPANCYBITMAP_HPP_ */
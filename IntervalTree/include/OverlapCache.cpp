@@ -0,0 +1,46 @@
+#ifndef OVERLAP_CACHE_CPP
+#define OVERLAP_CACHE_CPP
+
+template<typename T, typename Interval, typename Tree>
+OverlapCache<T, Interval, Tree>::OverlapCache(const Tree& tree, std::size_t capacity) : tree_(tree), capacity_(capacity),
+        modifications_(tree.modifications()), hits_(0UL), misses_(0UL) {
+    if (capacity == 0) {
+        throw std::invalid_argument("OverlapCache: capacity must be positive");
+    }
+}
+
+template<typename T, typename Interval, typename Tree>
+const std::vector<Interval>& OverlapCache<T, Interval, Tree>::overlapSearch(const Interval& window) {
+    if (tree_.modifications() != modifications_) {
+        clear();
+        modifications_ = tree_.modifications();
+    }
+    Key key(window.start(), window.end());
+    typename std::map<Key, typename Entries::iterator>::iterator found = index_.find(key);
+    if (found != index_.end()) {
+        ++hits_;
+        entries_.splice(entries_.begin(), entries_, found->second);
+        return found->second->result;
+    }
+
+    ++misses_;
+    if (entries_.size() < capacity_) {
+        entries_.push_front(Entry());
+    } else {
+        index_.erase(entries_.back().window);
+        entries_.splice(entries_.begin(), entries_, std::prev(entries_.end()));
+        entries_.front().result.clear();
+    }
+    Entry& entry = entries_.front();
+    entry.window = key;
+    try {
+        tree_.overlapSearch(window, entry.result);
+        index_[key] = entries_.begin();
+    } catch (...) {
+        entries_.pop_front();
+        throw;
+    }
+    return entry.result;
+}
+
+#endif /* OVERLAP_CACHE_CPP */
@@ -0,0 +1,99 @@
+/*
+ * OverlapCache.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: andrei
+ */
+
+#ifndef OVERLAPCACHE_HPP_
+#define OVERLAPCACHE_HPP_
+
+#include <iostream>
+#include <list>
+#include <map>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+
+#include <Interval.hpp>
+#include <IntervalTree.hpp>
+
+/**
+ * LRU cache of overlapSearch results of one tree, keyed by the query window, for the
+ * same windows asked again and again. The cache remembers IntervalTree::modifications()
+ * of the tree its results were computed from: after any change of the tree all of them
+ * are dropped at the next query, so a result is never stale.
+ *
+ * At most capacity windows are kept, a new one evicts the least recently used, whose
+ * result vector is reused. The tree must outlive the cache.
+ */
+template<typename T, typename Interval = IntervalT<T>, typename Tree = IntervalTree<T, Interval>>
+class OverlapCache {
+private:
+    typedef std::pair<T, T> Key;
+
+    struct Entry {
+        Key window;
+        std::vector<Interval> result;
+    };
+
+    typedef std::list<Entry> Entries;
+
+    const Tree& tree_;
+    std::size_t capacity_;
+    /**
+     * modifications() of the tree the entries were computed at.
+     */
+    unsigned long modifications_;
+    /**
+     * the most recently used first.
+     */
+    Entries entries_;
+    std::map<Key, typename Entries::iterator> index_;
+    unsigned long hits_;
+    unsigned long misses_;
+
+public:
+    /**
+     * capacity > 0 windows.
+     */
+    OverlapCache(const Tree& tree, std::size_t capacity);
+
+    OverlapCache(const OverlapCache&) = delete;
+    OverlapCache& operator=(const OverlapCache&) = delete;
+
+    std::size_t size() const {
+        return entries_.size();
+    }
+
+    std::size_t capacity() const {
+        return capacity_;
+    }
+
+    /**
+     * queries answered from the cache and by the tree.
+     */
+    unsigned long hits() const {
+        return hits_;
+    }
+    unsigned long misses() const {
+        return misses_;
+    }
+
+    void clear() {
+        entries_.clear();
+        index_.clear();
+    }
+
+    /**
+     * The intervals of the tree overlapping the window in the order of starts, as
+     * IntervalTree::overlapSearch(window, std::vector&) finds them.
+     * The reference is valid until the next call.
+     */
+    const std::vector<Interval>& overlapSearch(const Interval& window);
+};
+
+#include "OverlapCache.cpp"
+
+#endif /* OVERLAPCACHE_HPP_ */
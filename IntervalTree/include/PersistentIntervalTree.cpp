@@ -0,0 +1,255 @@
+#ifndef PERSISTENT_INTERVAL_TREE_CPP
+#define PERSISTENT_INTERVAL_TREE_CPP
+
+#include <stack>
+
+template<typename T, typename Interval>
+void PersistentIntervalTree<T, Interval>::release(NodePtr node) {
+    while (node != nullptr && node->refs_.fetch_sub(1U, std::memory_order_acq_rel) == 1U) {
+        NodePtr right = node->right_;
+        release(node->left_);
+        delete node;
+        /*
+         * tail position, the loop keeps the recursion as deep as the tree is high.
+         */
+        node = right;
+    }
+}
+
+/**
+ * height(x) = 1 + max(height(left(x)), height(right(x)))
+ * max(x) = max(rightendpoint(x), max(left(x)), max(right(x)))
+ * min(x) = min(leftendpoint(x), min(left(x)), min(right(x)))
+ */
+template<typename T, typename Interval>
+void PersistentIntervalTree<T, Interval>::update(NodePtr node) {
+    using std::max;
+    using std::min;
+
+    node->height_ = 1 + max(height(node->left_), height(node->right_));
+    node->max_ = node->key_.end();
+    node->min_ = node->key_.start();
+    if (node->left_ != nullptr) {
+        node->max_ = max(node->max_, node->left_->max_);
+        node->min_ = min(node->min_, node->left_->min_);
+    }
+    if (node->right_ != nullptr) {
+        node->max_ = max(node->max_, node->right_->max_);
+        node->min_ = min(node->min_, node->right_->min_);
+    }
+}
+
+/**
+ * The reference we hold is the only one when the counter is 1, no version
+ * or snapshot can observe the change.
+ */
+template<typename T, typename Interval>
+typename PersistentIntervalTree<T, Interval>::NodePtr PersistentIntervalTree<T, Interval>::writable(NodePtr node) {
+    if (node->refs_.load(std::memory_order_acquire) == 1U) {
+        return node;
+    }
+    NodePtr copy = new OrdinaryNode(*node);
+    release(node);
+    return copy;
+}
+
+/**
+ *  parent x    parent x
+ *   |            |
+ *   x            y
+ *  / \          / \
+ * a   \        /   c
+ *      y      x
+ *     / \    / \
+ *    b   c  a   b
+ */
+template<typename T, typename Interval>
+typename PersistentIntervalTree<T, Interval>::NodePtr PersistentIntervalTree<T, Interval>::rotateLeft(NodePtr x) {
+    NodePtr y = writable(x->right_);
+    x->right_ = y->left_;
+    update(x);
+    y->left_ = x;
+    update(y);
+    return y;
+}
+
+/**
+ *   parent x  parent x
+ *       |        |
+ *       x        y
+ *      / \      / \
+ *     /   c    a   \
+ *    y              x
+ *   / \            / \
+ *  a   b          b   c
+ */
+template<typename T, typename Interval>
+typename PersistentIntervalTree<T, Interval>::NodePtr PersistentIntervalTree<T, Interval>::rotateRight(NodePtr x) {
+    NodePtr y = writable(x->left_);
+    x->left_ = y->right_;
+    update(x);
+    y->right_ = x;
+    update(y);
+    return y;
+}
+
+template<typename T, typename Interval>
+typename PersistentIntervalTree<T, Interval>::NodePtr PersistentIntervalTree<T, Interval>::balance(NodePtr node) {
+    update(node);
+    int factor = height(node->left_) - height(node->right_);
+    if (factor > 1) {
+        if (height(node->left_->left_) < height(node->left_->right_)) {
+            node->left_ = rotateLeft(writable(node->left_));
+        }
+        return rotateRight(node);
+    }
+    if (factor < -1) {
+        if (height(node->right_->right_) < height(node->right_->left_)) {
+            node->right_ = rotateRight(writable(node->right_));
+        }
+        return rotateLeft(node);
+    }
+    return node;
+}
+
+template<typename T, typename Interval>
+typename PersistentIntervalTree<T, Interval>::NodePtr PersistentIntervalTree<T, Interval>::insert(NodePtr node, const Interval& key) {
+    if (node == nullptr) {
+        return new OrdinaryNode(key);
+    }
+    node = writable(node);
+    if (key < node->key_) {
+        node->left_ = insert(node->left_, key);
+    } else {
+        node->right_ = insert(node->right_, key);
+    }
+    return balance(node);
+}
+
+template<typename T, typename Interval>
+typename PersistentIntervalTree<T, Interval>::NodePtr PersistentIntervalTree<T, Interval>::removeMinimum(NodePtr node, NodePtr& minimum) {
+    node = writable(node);
+    if (node->left_ == nullptr) {
+        NodePtr right = node->right_;
+        node->right_ = nullptr;
+        minimum = node;
+        return right;
+    }
+    node->left_ = removeMinimum(node->left_, minimum);
+    return balance(node);
+}
+
+template<typename T, typename Interval>
+typename PersistentIntervalTree<T, Interval>::NodePtr PersistentIntervalTree<T, Interval>::remove(NodePtr node, const Interval& key) {
+    node = writable(node);
+    if (key < node->key_) {
+        node->left_ = remove(node->left_, key);
+        return balance(node);
+    } else if (key > node->key_) {
+        node->right_ = remove(node->right_, key);
+        return balance(node);
+    }
+
+    NodePtr left = node->left_;
+    NodePtr right = node->right_;
+    node->left_ = nullptr;
+    node->right_ = nullptr;
+    release(node);
+    if (left == nullptr) {
+        return right;
+    }
+    if (right == nullptr) {
+        return left;
+    }
+    /*
+     * the successor takes the place of the removed node.
+     */
+    NodePtr successor(nullptr);
+    right = removeMinimum(right, successor);
+    successor->left_ = left;
+    successor->right_ = right;
+    return balance(successor);
+}
+
+/**
+ * The presence of the key is checked first, so a failed update copies nothing
+ * and does not create a version.
+ */
+template<typename T, typename Interval>
+bool PersistentIntervalTree<T, Interval>::insert(const Interval& key) {
+    if (find(root_, key) != nullptr) {
+        return false;
+    }
+    root_ = insert(root_, key);
+    ++version_;
+    return true;
+}
+
+template<typename T, typename Interval>
+bool PersistentIntervalTree<T, Interval>::remove(const Interval& key) {
+    if (find(root_, key) == nullptr) {
+        return false;
+    }
+    root_ = remove(root_, key);
+    ++version_;
+    return true;
+}
+
+template<typename T, typename Interval>
+typename PersistentIntervalTree<T, Interval>::NodePtr PersistentIntervalTree<T, Interval>::find(const NodePtr node, const Interval& key) {
+    NodePtr found = node;
+    while (found != nullptr && found->key() != key) {
+        if (key < found->key()) {
+            found = found->left();
+        } else {
+            found = found->right();
+        }
+    }
+    return found;
+}
+
+template<typename T, typename Interval>
+const Interval& PersistentIntervalTree<T, Interval>::search(const NodePtr node, unsigned long offset) {
+    NodePtr found = node;
+    while (found != nullptr && static_cast<unsigned long>(found->key().start()) != offset) {
+        if (offset < static_cast<unsigned long>(found->key().start())) {
+            found = found->left();
+        } else {
+            found = found->right();
+        }
+    }
+    return found == nullptr ? nil() : found->key();
+}
+
+template<typename T, typename Interval>
+void PersistentIntervalTree<T, Interval>::overlapSearch(const NodePtr _root_, const Interval& i, std::set<Interval>& res) {
+    NodePtr curr = _root_;
+    if (curr == nullptr) {
+        return;
+    }
+    std::stack<NodePtr> s;
+    s.push(curr);
+    while (!s.empty()) {
+        curr = s.top();
+        s.pop();
+        if (overlap(curr->key(), i)) {
+            res.insert(curr->key());
+        }
+        /**
+         *          | max
+         *  start |----------| end
+         */
+        if (curr->left() != nullptr && curr->left()->max() > i.start()) {
+            s.push(curr->left());
+        }
+        /**
+         *                  | min
+         *  start |------------| end
+         */
+        if (curr->right() != nullptr && curr->right()->min() < i.end()) {
+            s.push(curr->right());
+        }
+    }
+}
+
+#endif // PERSISTENT_INTERVAL_TREE_CPP
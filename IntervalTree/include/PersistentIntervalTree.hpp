@@ -0,0 +1,305 @@
+/*
+ * PersistentIntervalTree.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: andrei
+ */
+
+#ifndef PERSISTENTINTERVALTREE_HPP_
+#define PERSISTENTINTERVALTREE_HPP_
+
+#include <iostream>
+#include <algorithm>
+#include <set>
+#include <atomic>
+
+#include <Interval.hpp>
+
+/**
+ * Persistent (versioned) interval tree.
+ *
+ * Each successful insert or remove produces a new version of the tree. The new version
+ * shares all unchanged subtrees with the previous one, only the O(log n) nodes on the
+ * path to the modified node are copied. snapshot() returns a handle to the current version
+ * in O(1), the handle keeps answering queries against that version whatever happens to
+ * the tree afterwards.
+ *
+ * Nodes are reference counted, a node is freed together with the last version that
+ * reaches it. A node that is referenced only by the current version is updated in place,
+ * so without live snapshots the tree allocates no more than an ordinary one.
+ *
+ * The tree is balanced by height (AVL), like ConcurrentIntervalTree, because the copied
+ * nodes cannot have parent pointers.
+ *
+ * The tree itself is not thread safe. Snapshots can be queried, copied and released
+ * from other threads.
+ *
+ * see also "Making data structures persistent", J. R. Driscoll, N. Sarnak, D. D. Sleator, R. E. Tarjan.
+ */
+template<typename T, typename Interval = IntervalT<T>>
+class PersistentIntervalTree {
+private:
+
+    /**
+     * type that represents a node in the tree.
+     * A node shared by several versions is immutable.
+     */
+    class OrdinaryNode {
+    private:
+        OrdinaryNode *left_;
+        OrdinaryNode *right_;
+        Interval key_;
+        int height_;
+        /**
+         * Node is augmented with maximal right endpoint in subtree rooted in x.
+         */
+        unsigned long max_;
+        /**
+         * Node is augmented with minimal left endpoint in subtree rooted in x.
+         */
+        unsigned long min_;
+        /**
+         * number of parents and versions referring to the node.
+         */
+        std::atomic<unsigned> refs_;
+    public:
+        explicit OrdinaryNode(const Interval& key) :
+                left_(nullptr), right_(nullptr), key_(key), height_(1),
+                max_(key.end()), min_(key.start()), refs_(1U) {}
+
+        /**
+         * copy shares the children of the node.
+         */
+        OrdinaryNode(const OrdinaryNode& node) :
+                left_(retain(node.left_)), right_(retain(node.right_)), key_(node.key_), height_(node.height_),
+                max_(node.max_), min_(node.min_), refs_(1U) {}
+
+        OrdinaryNode* left() const {
+            return left_;
+        }
+        OrdinaryNode* right() const {
+            return right_;
+        }
+        const Interval& key() const {
+            return key_;
+        }
+        unsigned long max() const {
+            return max_;
+        }
+        unsigned long min() const {
+            return min_;
+        }
+        friend class PersistentIntervalTree;
+    };
+
+    typedef OrdinaryNode* NodePtr;
+
+    NodePtr root_;
+    unsigned long version_;
+
+    static const Interval& nil() {
+        static const Interval invalid;
+        return invalid;
+    }
+
+    static NodePtr retain(NodePtr node) {
+        if (node != nullptr) {
+            node->refs_.fetch_add(1U, std::memory_order_relaxed);
+        }
+        return node;
+    }
+
+    /**
+     * drop one reference, free the node and release its children with the last one.
+     */
+    static void release(NodePtr node);
+
+    static int height(NodePtr node) {
+        return node == nullptr ? 0 : node->height_;
+    }
+
+    /**
+     * recalculate height and augmentation of the writable node.
+     */
+    static void update(NodePtr node);
+
+    /**
+     * takes the reference to the node, returns the reference to the node that can
+     * be changed in place: the node itself if nobody else refers to it, otherwise its copy.
+     */
+    static NodePtr writable(NodePtr node);
+
+    static NodePtr rotateLeft(NodePtr x);
+    static NodePtr rotateRight(NodePtr x);
+
+    /**
+     * restore AVL balance at the writable node.
+     */
+    static NodePtr balance(NodePtr node);
+
+    /**
+     * the functions below take the reference to the subtree and return the
+     * reference to the updated subtree. The key must be absent (insert)
+     * or present (remove).
+     */
+    static NodePtr insert(NodePtr node, const Interval& key);
+    static NodePtr remove(NodePtr node, const Interval& key);
+
+    /**
+     * detach the node with the minimum key from the subtree.
+     * minimum is writable and has no children.
+     */
+    static NodePtr removeMinimum(NodePtr node, NodePtr& minimum);
+
+    /**
+     * the node of the key, nullptr if the key is absent.
+     */
+    static NodePtr find(const NodePtr node, const Interval& key);
+
+    static const Interval& search(const NodePtr node, const Interval& key) {
+        NodePtr found = find(node, key);
+        return found == nullptr ? nil() : found->key();
+    }
+    static const Interval& search(const NodePtr node, unsigned long offset);
+    static void overlapSearch(const NodePtr _root_, const Interval& i, std::set<Interval>& res);
+
+public:
+
+    /**
+     * Read only handle to one version of the tree.
+     */
+    class Snapshot {
+    private:
+        NodePtr root_;
+        unsigned long version_;
+
+        Snapshot(NodePtr root, unsigned long version) : root_(retain(root)), version_(version) {}
+    public:
+        Snapshot(const Snapshot& other) : root_(retain(other.root_)), version_(other.version_) {}
+
+        Snapshot& operator=(const Snapshot& other) {
+            NodePtr root = retain(other.root_);
+            release(root_);
+            root_ = root;
+            version_ = other.version_;
+            return *this;
+        }
+
+        ~Snapshot() {
+            release(root_);
+        }
+
+        unsigned long version() const {
+            return version_;
+        }
+
+        bool empty() const {
+            return root_ == nullptr;
+        }
+
+        /**
+         * see PersistentIntervalTree::search
+         */
+        const Interval& search(const Interval& k) const {
+            return PersistentIntervalTree::search(root_, k);
+        }
+
+        const Interval& search(unsigned long offset) const {
+            return PersistentIntervalTree::search(root_, offset);
+        }
+
+        void overlapSearch(const Interval& i, std::set<Interval>& res) const {
+            PersistentIntervalTree::overlapSearch(root_, i, res);
+        }
+
+        friend class PersistentIntervalTree;
+    };
+
+    PersistentIntervalTree() : root_(nullptr), version_(0UL) {}
+
+    /**
+     * the copy shares all nodes with the original, O(1).
+     */
+    PersistentIntervalTree(const PersistentIntervalTree& other) : root_(retain(other.root_)), version_(other.version_) {}
+
+    PersistentIntervalTree& operator=(const PersistentIntervalTree& other) {
+        NodePtr root = retain(other.root_);
+        release(root_);
+        root_ = root;
+        version_ = other.version_;
+        return *this;
+    }
+
+    /**
+     * the tree goes back to the version of the snapshot.
+     */
+    explicit PersistentIntervalTree(const Snapshot& snapshot) : root_(retain(snapshot.root_)), version_(snapshot.version_) {}
+
+    ~PersistentIntervalTree() {
+        release(root_);
+    }
+
+    bool empty() const {
+        return root_ == nullptr;
+    }
+
+    /**
+     * number of modifications made to the tree, the version of the next snapshot.
+     */
+    unsigned long version() const {
+        return version_;
+    }
+
+    /**
+     * O(1) handle to the current version.
+     */
+    Snapshot snapshot() const {
+        return Snapshot(root_, version_);
+    }
+
+    void clear() {
+        if (!empty()) {
+            release(root_);
+            root_ = nullptr;
+            ++version_;
+        }
+    }
+
+    /**
+     * search the tree for the key k and return the corresponding Interval
+     * Return reference to valid interval if found and reference to not valid otherwise.
+     * The client should check the interval by calling Interval::isValid ().
+     */
+    const Interval& search(const Interval& k) const {
+        return search(root_, k);
+    }
+
+    /**
+     * Search the tree for the interval with given offset.
+     * Return reference to valid interval if found and reference to not valid otherwise.
+     */
+    const Interval& search(unsigned long offset) const {
+        return search(root_, offset);
+    }
+
+    /**
+     * Finds in the current version intervals overlapping with the given.
+     */
+    void overlapSearch(const Interval& i, std::set<Interval>& res) const {
+        overlapSearch(root_, i, res);
+    }
+
+    /**
+     * insert the key, the previous version stays available to its snapshots.
+     */
+    bool insert(const Interval& key);
+
+    /**
+     * delete the key, the previous version stays available to its snapshots.
+     */
+    bool remove(const Interval& key);
+};
+
+#include "PersistentIntervalTree.cpp"
+
+#endif /* PERSISTENTINTERVALTREE_HPP_ */
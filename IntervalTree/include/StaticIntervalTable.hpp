@@ -0,0 +1,222 @@
+/*
+ * StaticIntervalTable.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: andrei
+ */
+
+#ifndef STATICINTERVALTABLE_HPP_
+#define STATICINTERVALTABLE_HPP_
+
+#if __cplusplus < 201703L
+#error "StaticIntervalTable.hpp requires C++17"
+#endif
+
+#include <cstddef>
+#include <stdexcept>
+
+/**
+ * Half open interval [start, end[ with a value, the entry of StaticIntervalTable.
+ * Literal type, so tables can be written as constexpr arrays.
+ */
+template<typename T, typename Value>
+struct StaticEntry {
+    T start;
+    T end;
+    Value value;
+
+    constexpr T length() const {
+        return end - start;
+    }
+
+    constexpr bool contained(T point) const {
+        return point >= start && point < end;
+    }
+};
+
+/**
+ * Read only interval index built at compile time.
+ *
+ * Routing or memory map tables known at build time are sorted and laid out by the
+ * compiler, the program starts with the table ready, nothing is inserted at startup.
+ * The entries are kept sorted by start together with the running maximum of ends and
+ * the innermost enclosing entry of each entry. A lookup is a binary search over an
+ * array of the size known at compile time, which the compiler unrolls, and a walk back
+ * that jumps from an entry ending before the point to the entry enclosing it, so a long
+ * entry such as a default route is reached in one step: O(log N + d) for the nesting
+ * depth d of the entries ending before the point.
+ *
+ *   constexpr StaticEntry<unsigned, int> entries[] = {{0x1000, 0x2000, 1}, {0x0, 0x1000, 0}};
+ *   constexpr StaticIntervalTable table(entries);
+ *   static_assert(table.find(0x1800)->value == 1);
+ */
+template<typename T, std::size_t N, typename Value>
+class StaticIntervalTable {
+public:
+    typedef StaticEntry<T, Value> Entry;
+
+private:
+    static_assert(N > 0, "the table must not be empty");
+
+    Entry entries_[N];
+    /**
+     * maxEnd_[i] - the greatest end among entries_[0..i].
+     */
+    T maxEnd_[N];
+    /**
+     * parent_[i] - the greatest j < i with entries_[j].end >= entries_[i].end, N if none.
+     * Starts are distinct, so it is the innermost entry containing entries_[i], and the
+     * entries between the two end before entries_[i] ends.
+     */
+    std::size_t parent_[N];
+
+    static constexpr bool less(const Entry& e1, const Entry& e2) {
+        return e1.start < e2.start;
+    }
+
+    static constexpr void swap(Entry& e1, Entry& e2) {
+        Entry tmp = e1;
+        e1 = e2;
+        e2 = tmp;
+    }
+
+    /**
+     * heapsort, O(N log N) steps of constant evaluation.
+     */
+    constexpr void siftDown(std::size_t root, std::size_t size) {
+        for (std::size_t child = 2 * root + 1; child < size; child = 2 * root + 1) {
+            if (child + 1 < size && less(entries_[child], entries_[child + 1])) {
+                ++child;
+            }
+            if (!less(entries_[root], entries_[child])) {
+                return;
+            }
+            swap(entries_[root], entries_[child]);
+            root = child;
+        }
+    }
+
+    constexpr void sort() {
+        for (std::size_t i = N / 2; i > 0; --i) {
+            siftDown(i - 1, N);
+        }
+        for (std::size_t size = N - 1; size > 0; --size) {
+            swap(entries_[0], entries_[size]);
+            siftDown(0, size);
+        }
+    }
+
+    /**
+     * index of the last entry with start <= point (start < point if strict),
+     * N if there is none. The loop depends only on N.
+     */
+    constexpr std::size_t lastStarting(T point, bool strict) const {
+        std::size_t base = 0;
+        for (std::size_t len = N; len > 1; len -= len / 2) {
+            T start = entries_[base + len / 2].start;
+            base = start < point || (!strict && start == point) ? base + len / 2 : base;
+        }
+        T start = entries_[base].start;
+        return start < point || (!strict && start == point) ? base : N;
+    }
+
+public:
+    /**
+     * Throws std::invalid_argument (a compile error in a constant expression)
+     * if an entry has start > end or two entries have the same start.
+     */
+    constexpr StaticIntervalTable(const StaticEntry<T, Value> (&entries)[N]) : entries_{}, maxEnd_{}, parent_{} {
+        for (std::size_t i = 0; i < N; ++i) {
+            if (entries[i].start > entries[i].end) {
+                throw std::invalid_argument("start > end");
+            }
+            entries_[i] = entries[i];
+        }
+        sort();
+        for (std::size_t i = 0; i < N; ++i) {
+            if (i > 0 && entries_[i - 1].start == entries_[i].start) {
+                throw std::invalid_argument("duplicate start");
+            }
+            maxEnd_[i] = i == 0 || entries_[i].end > maxEnd_[i - 1] ? entries_[i].end : maxEnd_[i - 1];
+            /*
+             * entries skipped through a parent are never looked at again, O(N) in total.
+             */
+            std::size_t parent = i == 0 ? N : i - 1;
+            while (parent != N && entries_[parent].end < entries_[i].end) {
+                parent = parent_[parent];
+            }
+            parent_[i] = parent;
+        }
+    }
+
+    constexpr std::size_t size() const {
+        return N;
+    }
+
+    constexpr const Entry& operator[](std::size_t i) const {
+        return entries_[i];
+    }
+
+    constexpr const Entry* begin() const {
+        return entries_;
+    }
+
+    constexpr const Entry* end() const {
+        return entries_ + N;
+    }
+
+    /**
+     * The entry starting at the offset, nullptr if there is none.
+     * Semantic of IntervalTree::search(offset).
+     */
+    constexpr const Entry* search(T offset) const {
+        std::size_t i = lastStarting(offset, false);
+        return i != N && entries_[i].start == offset ? entries_ + i : nullptr;
+    }
+
+    /**
+     * The innermost entry containing the entry of the table, nullptr for a top level one.
+     */
+    constexpr const Entry* enclosing(const Entry& entry) const {
+        std::size_t parent = parent_[&entry - entries_];
+        return parent == N ? nullptr : entries_ + parent;
+    }
+
+    /**
+     * The entry containing the point with the greatest start (the innermost one
+     * for nested entries), nullptr if no entry contains the point.
+     */
+    constexpr const Entry* find(T point) const {
+        std::size_t i = lastStarting(point, false);
+        while (i != N && maxEnd_[i] > point) {
+            if (entries_[i].end > point) {
+                return entries_ + i;
+            }
+            i = parent_[i];
+        }
+        return nullptr;
+    }
+
+    /**
+     * Call visit(const Entry&) for each entry overlapping [start, end[,
+     * in the order of descending starts.
+     * O(log N + (k + 1) d) for k entries visited and the nesting depth d.
+     */
+    template<typename Visitor>
+    constexpr void overlapSearch(T start, T end, Visitor visit) const {
+        if (!(start < end)) {
+            return;
+        }
+        std::size_t i = lastStarting(end, true);
+        while (i != N && maxEnd_[i] > start) {
+            if (entries_[i].end > start) {
+                visit(entries_[i]);
+                i = i == 0 ? N : i - 1;
+            } else {
+                i = parent_[i];
+            }
+        }
+    }
+};
+
+#endif /* STATICINTERVALTABLE_HPP_ */
@@ -0,0 +1,276 @@
+/*
+ * interval_algebra.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: andrei
+ */
+
+#ifndef INTERVAL_ALGEBRA_HPP_
+#define INTERVAL_ALGEBRA_HPP_
+
+#include <algorithm>
+#include <cstddef>
+
+/**
+ * Bulk set operations over lists of half open intervals [starts[k], ends[k]) kept as
+ * two parallel arrays sorted by start: the bounds are compared and copied in runs
+ * straight from the arrays, without building an Interval (no valueOf, no exceptions).
+ *
+ * A list is normalized if every interval is non-empty and ends before the next one
+ * starts, ends[k] < starts[k + 1], so the ends are sorted too. sorted_normalize makes
+ * one of any sorted list, the other operations take normalized lists and give one.
+ *
+ * The results are written into arrays of the caller, large enough for the bound given
+ * for each operation, and the functions return the number of intervals written.
+ * Linear merges: a run of intervals that cannot interact with the other list is found
+ * by comparing blocks of bounds without branches, which compilers turn into SIMD
+ * compares, and is copied as it is.
+ */
+template<typename T>
+struct IntervalList {
+    T* starts;
+    T* ends;
+    std::size_t size;
+};
+
+/**
+ * the number of the leading elements of x for which the predicate holds; it holds
+ * for a prefix of x. A block is compared whole, the first one not entirely in the
+ * prefix ends the scan.
+ */
+template<typename T, typename Predicate>
+inline std::size_t sortedLeading(const T* x, std::size_t n, Predicate holds) {
+    const std::size_t BLOCK = 16;
+    std::size_t k = 0;
+    while (k + BLOCK <= n) {
+        std::size_t count = 0;
+        for (std::size_t b = 0; b < BLOCK; ++b) {
+            count += holds(x[k + b]) ? 1 : 0;
+        }
+        k += count;
+        if (count < BLOCK) {
+            return k;
+        }
+    }
+    while (k < n && holds(x[k])) {
+        ++k;
+    }
+    return k;
+}
+
+/**
+ * the length of the normalized prefix of a sorted list whose first interval is not empty.
+ */
+template<typename T>
+inline std::size_t sortedNormalizedRun(const T* starts, const T* ends, std::size_t n) {
+    const std::size_t BLOCK = 16;
+    std::size_t k = 1;
+    while (k + BLOCK <= n) {
+        unsigned clean = 1;
+        for (std::size_t b = k; b < k + BLOCK; ++b) {
+            clean &= static_cast<unsigned>(starts[b] < ends[b]) & static_cast<unsigned>(ends[b - 1] < starts[b]);
+        }
+        if (clean == 0) {
+            break;
+        }
+        k += BLOCK;
+    }
+    while (k < n && starts[k] < ends[k] && ends[k - 1] < starts[k]) {
+        ++k;
+    }
+    return k;
+}
+
+/**
+ * Normalize the list in place: empty intervals go, overlapping and touching ones are
+ * merged. The list must be sorted by start. Returns the new size.
+ */
+template<typename T>
+std::size_t sorted_normalize(T* starts, T* ends, std::size_t size) {
+    std::size_t n = 0, k = 0;
+    while (k < size) {
+        if (!(starts[k] < ends[k])) {
+            ++k;
+        } else if (n > 0 && !(ends[n - 1] < starts[k])) {
+            ends[n - 1] = std::max(ends[n - 1], ends[k]);
+            ++k;
+        } else {
+            /*
+             * an interval after the output: it and the normalized run behind it stay.
+             */
+            std::size_t run = sortedNormalizedRun(starts + k, ends + k, size - k);
+            if (n != k) {
+                std::copy(starts + k, starts + k + run, starts + n);
+                std::copy(ends + k, ends + k + run, ends + n);
+            }
+            n += run;
+            k += run;
+        }
+    }
+    return n;
+}
+
+template<typename T>
+inline std::size_t sorted_normalize(IntervalList<T> list) {
+    return sorted_normalize(list.starts, list.ends, list.size);
+}
+
+/**
+ * Union of the normalized lists a and b, at most a.size + b.size intervals.
+ * The intervals are taken in the order of starts and merged with the last one written
+ * if they overlap or touch it; an interval after it goes with the intervals behind it
+ * in its list ending before the next interval of the other list.
+ */
+template<typename T>
+std::size_t sorted_union(IntervalList<const T> a, IntervalList<const T> b, T* starts, T* ends) {
+    std::size_t i = 0, j = 0, n = 0;
+    while (i < a.size || j < b.size) {
+        bool first = j == b.size || (i < a.size && !(b.starts[j] < a.starts[i]));
+        const IntervalList<const T>& x = first ? a : b;
+        const IntervalList<const T>& y = first ? b : a;
+        std::size_t& k = first ? i : j;
+        std::size_t m = first ? j : i;
+        if (n > 0 && !(ends[n - 1] < x.starts[k])) {
+            ends[n - 1] = std::max(ends[n - 1], x.ends[k]);
+            ++k;
+            continue;
+        }
+        std::size_t run = x.size - k;
+        if (m < y.size) {
+            T bound = y.starts[m];
+            run = 1 + sortedLeading(x.ends + k + 1, x.size - k - 1, [bound](T end) {
+                return end < bound;
+            });
+        }
+        std::copy(x.starts + k, x.starts + k + run, starts + n);
+        std::copy(x.ends + k, x.ends + k + run, ends + n);
+        n += run;
+        k += run;
+    }
+    return n;
+}
+
+/**
+ * Intersection of the normalized lists a and b, at most a.size + b.size - 1 intervals.
+ * The intervals of one list ending before the current interval of the other are skipped.
+ */
+template<typename T>
+std::size_t sorted_intersect(IntervalList<const T> a, IntervalList<const T> b, T* starts, T* ends) {
+    std::size_t i = 0, j = 0, n = 0;
+    while (i < a.size && j < b.size) {
+        T as = a.starts[i], bs = b.starts[j];
+        if (!(bs < a.ends[i])) {
+            i += sortedLeading(a.ends + i, a.size - i, [bs](T end) {
+                return !(bs < end);
+            });
+        } else if (!(as < b.ends[j])) {
+            j += sortedLeading(b.ends + j, b.size - j, [as](T end) {
+                return !(as < end);
+            });
+        } else {
+            starts[n] = std::max(as, bs);
+            ends[n] = std::min(a.ends[i], b.ends[j]);
+            ++n;
+            if (a.ends[i] < b.ends[j]) {
+                ++i;
+            } else {
+                ++j;
+            }
+        }
+    }
+    return n;
+}
+
+/**
+ * Difference a - b of the normalized lists, at most a.size + b.size intervals.
+ * The intervals of a ending before the next interval of b are copied as they are,
+ * an interval of a overlapping intervals of b leaves the gaps between them.
+ */
+template<typename T>
+std::size_t sorted_difference(IntervalList<const T> a, IntervalList<const T> b, T* starts, T* ends) {
+    std::size_t i = 0, j = 0, n = 0;
+    while (i < a.size) {
+        T start = a.starts[i], end = a.ends[i];
+        j += sortedLeading(b.ends + j, b.size - j, [start](T e) {
+            return !(start < e);
+        });
+        std::size_t run = a.size - i;
+        if (j < b.size) {
+            T bound = b.starts[j];
+            run = sortedLeading(a.ends + i, a.size - i, [bound](T e) {
+                return !(bound < e);
+            });
+        }
+        if (run > 0) {
+            std::copy(a.starts + i, a.starts + i + run, starts + n);
+            std::copy(a.ends + i, a.ends + i + run, ends + n);
+            n += run;
+            i += run;
+            continue;
+        }
+        /*
+         * b[j] overlaps a[i]: the pieces of a[i] between the intervals of b, b[j] can go
+         * on into the next interval of a, so j stays on the last one.
+         */
+        while (j < b.size && b.starts[j] < end) {
+            if (start < b.starts[j]) {
+                starts[n] = start;
+                ends[n] = b.starts[j];
+                ++n;
+            }
+            if (!(b.ends[j] < end)) {
+                start = end;
+                break;
+            }
+            start = b.ends[j];
+            ++j;
+        }
+        if (start < end) {
+            starts[n] = start;
+            ends[n] = end;
+            ++n;
+        }
+        ++i;
+    }
+    return n;
+}
+
+/**
+ * The gaps of the normalized list a within [lo, hi), at most a.size + 1 intervals.
+ * Between the first and the last interval of a inside the range the gaps are the ends
+ * and the starts shifted by one, copied as they are.
+ */
+template<typename T>
+std::size_t sorted_complement(IntervalList<const T> a, T lo, T hi, T* starts, T* ends) {
+    if (!(lo < hi)) {
+        return 0;
+    }
+    std::size_t first = sortedLeading(a.ends, a.size, [lo](T end) {
+        return !(lo < end);
+    });
+    std::size_t last = first + sortedLeading(a.starts + first, a.size - first, [hi](T start) {
+        return start < hi;
+    });
+    std::size_t n = 0;
+    if (first == last) {
+        starts[n] = lo;
+        ends[n] = hi;
+        return 1;
+    }
+    if (lo < a.starts[first]) {
+        starts[n] = lo;
+        ends[n] = a.starts[first];
+        ++n;
+    }
+    std::copy(a.ends + first, a.ends + last - 1, starts + n);
+    std::copy(a.starts + first + 1, a.starts + last, ends + n);
+    n += last - 1 - first;
+    if (a.ends[last - 1] < hi) {
+        starts[n] = a.ends[last - 1];
+        ends[n] = hi;
+        ++n;
+    }
+    return n;
+}
+
+#endif /* INTERVAL_ALGEBRA_HPP_ */
@@ -0,0 +1,165 @@
+/*
+ * overlap_join.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: andrei
+ */
+
+#ifndef OVERLAP_JOIN_HPP_
+#define OVERLAP_JOIN_HPP_
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cstddef>
+
+#include <IntervalTree.hpp>
+
+/**
+ * index of the first interval starting at or after the point.
+ */
+template<typename T, typename Interval>
+std::size_t overlapJoinLowerBound(const std::vector<const Interval*>& intervals, T point) {
+    std::size_t first = 0, count = intervals.size();
+    while (count > 0) {
+        std::size_t half = count / 2;
+        if (intervals[first + half]->start() < point) {
+            first += half + 1;
+            count -= half + 1;
+        } else {
+            count = half;
+        }
+    }
+    return first;
+}
+
+/**
+ * open[p] - the intervals starting before cuts[p] and ending after it. One pass,
+ * the list of open intervals is filtered at each cut only.
+ */
+template<typename T, typename Interval>
+void overlapJoinOpen(const std::vector<const Interval*>& intervals, const std::vector<std::size_t>& first,
+        const std::vector<T>& cuts, std::vector<std::vector<const Interval*>>& open) {
+    std::vector<const Interval*> active;
+    for (std::size_t p = 1; p < cuts.size(); ++p) {
+        active.insert(active.end(), intervals.begin() + first[p - 1], intervals.begin() + first[p]);
+        T cut = cuts[p];
+        active.erase(std::remove_if(active.begin(), active.end(), [cut](const Interval* i) {
+            return !(cut < i->end());
+        }), active.end());
+        open[p] = active;
+    }
+}
+
+/**
+ * Report the pairs of x with the open intervals of the other tree, the open intervals
+ * ending before x starts are dropped on the way. Every interval looked at is either
+ * reported or dropped, so the sweep is output sensitive.
+ */
+template<typename Interval, typename Report>
+void overlapJoinReport(const Interval& x, std::vector<const Interval*>& open, Report report) {
+    for (std::size_t k = 0; k < open.size();) {
+        if (!(x.start() < open[k]->end())) {
+            open[k] = open.back();
+            open.pop_back();
+        } else {
+            report(*open[k]);
+            ++k;
+        }
+    }
+}
+
+/**
+ * Plane sweep over the intervals starting in the slab [first, last) of both trees,
+ * in the order of starts. A pair is reported when the interval starting later arrives,
+ * the one of a first for equal starts.
+ */
+template<typename Interval, typename Sink>
+void overlapJoinSweep(const std::vector<const Interval*>& a, std::size_t ia, std::size_t lastA,
+        const std::vector<const Interval*>& b, std::size_t ib, std::size_t lastB,
+        std::vector<const Interval*>& openA, std::vector<const Interval*>& openB,
+        std::size_t part, Sink& sink) {
+    while (ia < lastA || ib < lastB) {
+        if (ib == lastB || (ia < lastA && !(b[ib]->start() < a[ia]->start()))) {
+            const Interval& x = *a[ia++];
+            if (x.start() < x.end()) {
+                overlapJoinReport(x, openB, [&](const Interval& y) {
+                    sink(part, x, y);
+                });
+                openA.push_back(&x);
+            }
+        } else {
+            const Interval& y = *b[ib++];
+            if (y.start() < y.end()) {
+                overlapJoinReport(y, openA, [&](const Interval& x) {
+                    sink(part, x, y);
+                });
+                openB.push_back(&y);
+            }
+        }
+    }
+}
+
+/**
+ * All pairs of overlapping intervals, x of the tree a and y of the tree b:
+ * calls sink(std::size_t part, const Interval& x, const Interval& y) once for each pair.
+ *
+ * The trees are read in order of starts and swept once, O(n + m + k) for k pairs,
+ * instead of an overlapSearch in b for every interval of a.
+ *
+ * With threads > 1 the coordinates are cut into slabs with equal numbers of
+ * intervals, each slab is swept by its own thread starting with the intervals still
+ * open at the slab start. part < threads is the slab, the sink is called concurrently
+ * for different parts, e.g. it appends to a buffer per part without locking.
+ * The trees can differ in allocators, augmentations and balancing policies.
+ * The trees must not change during the join.
+ */
+template<typename T, typename Interval, typename AllocatorA, typename AugmentA, typename BalanceA,
+        typename AllocatorB, typename AugmentB, typename BalanceB, typename Sink>
+void overlapJoin(const IntervalTree<T, Interval, AllocatorA, AugmentA, BalanceA>& treeA,
+        const IntervalTree<T, Interval, AllocatorB, AugmentB, BalanceB>& treeB, Sink sink, unsigned threads = 1) {
+    typedef std::vector<const Interval*> Intervals;
+
+    Intervals a, b;
+    treeA.forEach([&a](const Interval& i) {
+        a.push_back(&i);
+    });
+    treeB.forEach([&b](const Interval& i) {
+        b.push_back(&i);
+    });
+    if (a.empty() || b.empty()) {
+        return;
+    }
+
+    /*
+     * cuts[p] - the start of the slab p, the slab 0 starts at the beginning.
+     */
+    const Intervals& larger = a.size() < b.size() ? b : a;
+    std::size_t parts = std::max<std::size_t>(1, std::min<std::size_t>(threads, larger.size()));
+    std::vector<T> cuts(parts);
+    std::vector<std::size_t> firstA(parts + 1, 0), firstB(parts + 1, 0);
+    for (std::size_t p = 1; p < parts; ++p) {
+        cuts[p] = larger[p * larger.size() / parts]->start();
+        firstA[p] = overlapJoinLowerBound(a, cuts[p]);
+        firstB[p] = overlapJoinLowerBound(b, cuts[p]);
+    }
+    firstA[parts] = a.size();
+    firstB[parts] = b.size();
+
+    std::vector<Intervals> openA(parts), openB(parts);
+    overlapJoinOpen(a, firstA, cuts, openA);
+    overlapJoinOpen(b, firstB, cuts, openB);
+
+    std::vector<std::thread> workers;
+    for (std::size_t p = 1; p < parts; ++p) {
+        workers.push_back(std::thread([&, p]() {
+            overlapJoinSweep(a, firstA[p], firstA[p + 1], b, firstB[p], firstB[p + 1], openA[p], openB[p], p, sink);
+        }));
+    }
+    overlapJoinSweep(a, firstA[0], firstA[1], b, firstB[0], firstB[1], openA[0], openB[0], 0, sink);
+    for (std::size_t p = 0; p < workers.size(); ++p) {
+        workers[p].join();
+    }
+}
+
+#endif /* OVERLAP_JOIN_HPP_ */
@@ -0,0 +1,182 @@
+#include <iostream>
+#include <cassert>
+#include <vector>
+#include <set>
+#include <memory_resource>
+
+#include <StaticIntervalTable.hpp>
+#include <IntervalTree.hpp>
+#include <interval_operations.hpp>
+
+/**
+ * Tests of the parts of the library that need C++17.
+ */
+
+/**
+ * memory map known at build time, deliberately out of order.
+ */
+constexpr StaticEntry<unsigned long, int> memoryMap[] = {
+        {0x40000000UL, 0x40001000UL, 3},
+        {0x00000000UL, 0x00100000UL, 0},
+        {0x20000000UL, 0x20010000UL, 1},
+        {0x20004000UL, 0x20008000UL, 2},
+        {0x40001000UL, 0x40001400UL, 4}
+};
+
+constexpr StaticIntervalTable table(memoryMap);
+
+/**
+ * everything below is evaluated by the compiler.
+ */
+static_assert(table.size() == 5, "size");
+static_assert(table[0].start == 0x00000000UL && table[4].start == 0x40001000UL, "sorted at compile time");
+static_assert(table.find(0x00000010UL)->value == 0, "find");
+static_assert(table.find(0x20000010UL)->value == 1, "find in the enclosing entry");
+static_assert(table.find(0x20004010UL)->value == 2, "find the innermost entry");
+static_assert(table.find(0x20009000UL)->value == 1, "find after the nested entry");
+static_assert(table.find(0x40001000UL)->value == 4, "end is excluded");
+static_assert(table.find(0x30000000UL) == nullptr, "hole");
+static_assert(table.find(0x50000000UL) == nullptr, "after the last entry");
+static_assert(table.search(0x20004000UL)->value == 2, "search by start");
+static_assert(table.search(0x20004001UL) == nullptr, "search by start");
+
+constexpr int countOverlaps(unsigned long start, unsigned long end) {
+    int count = 0;
+    table.overlapSearch(start, end, [&count](const StaticEntry<unsigned long, int>&) {
+        ++count;
+    });
+    return count;
+}
+
+static_assert(countOverlaps(0x20003000UL, 0x20005000UL) == 2, "overlapSearch");
+static_assert(countOverlaps(0x00100000UL, 0x20000000UL) == 0, "overlapSearch in a hole");
+static_assert(countOverlaps(0x0UL, 0x50000000UL) == 5, "overlapSearch of everything");
+
+/**
+ * routing table with a default route enclosing every other entry.
+ */
+constexpr StaticEntry<unsigned long, int> routes[] = {
+        {0x00000000UL, 0xffffffffUL, 0},
+        {0x0a000000UL, 0x0b000000UL, 1},
+        {0x0a010000UL, 0x0a020000UL, 2},
+        {0x0a010100UL, 0x0a010200UL, 3},
+        {0x0a030000UL, 0x0a040000UL, 4},
+        {0xc0a80000UL, 0xc0a90000UL, 5},
+        {0xc0a80100UL, 0xc0a80200UL, 6},
+        {0xc0a80300UL, 0xc0a80400UL, 7}
+};
+
+constexpr StaticIntervalTable routing(routes);
+
+static_assert(routing.enclosing(routing[0]) == nullptr, "the default route is top level");
+static_assert(routing.enclosing(routing[3])->value == 2, "innermost enclosing entry");
+static_assert(routing.enclosing(routing[4])->value == 1, "the sibling before is skipped");
+static_assert(routing.enclosing(routing[7])->value == 5, "the sibling before is skipped");
+static_assert(routing.find(0xc0a80500UL)->value == 5, "jump over the siblings ending before");
+static_assert(routing.find(0x0a050000UL)->value == 1, "jump over the siblings ending before");
+static_assert(routing.find(0xd0000000UL)->value == 0, "default route");
+static_assert(routing.find(0x0a010150UL)->value == 3, "find the innermost entry");
+static_assert(routing.find(0xffffffffUL) == nullptr, "end is excluded");
+
+constexpr int countRoutes(unsigned long start, unsigned long end) {
+    int count = 0;
+    routing.overlapSearch(start, end, [&count](const StaticEntry<unsigned long, int>&) {
+        ++count;
+    });
+    return count;
+}
+
+static_assert(countRoutes(0x0a01ff00UL, 0x0a030100UL) == 4, "overlapSearch over nested entries");
+static_assert(countRoutes(0xc0a80500UL, 0xc0a80600UL) == 2, "overlapSearch in a gap of the siblings");
+
+void staticIntervalTable_Test() {
+    /**
+     * the same answers at run time, compared with a linear scan.
+     */
+    for (unsigned long point = 0; point < 0x50000000UL; point += 0x1000UL - 7) {
+        const StaticEntry<unsigned long, int>* expected = nullptr;
+        for (const auto& e: table) {
+            if (e.contained(point) && (expected == nullptr || expected->start < e.start)) {
+                expected = &e;
+            }
+        }
+        assert(table.find(point) == expected);
+    }
+
+    for (unsigned long point = 0; point < 0xffffffffUL; point += 0x00ffff01UL) {
+        for (unsigned long offset = 0; offset < 0x00050000UL; offset += 0x3f01UL) {
+            const StaticEntry<unsigned long, int>* expected = nullptr;
+            for (const auto& e: routing) {
+                if (e.contained(point + offset) && (expected == nullptr || expected->start < e.start)) {
+                    expected = &e;
+                }
+            }
+            assert(routing.find(point + offset) == expected);
+        }
+    }
+    for (unsigned long start = 0x0a000000UL; start < 0x0a050000UL; start += 0x0f01UL) {
+        std::vector<int> visited;
+        routing.overlapSearch(start, start + 0x1000UL, [&visited](const StaticEntry<unsigned long, int>& e) {
+            visited.push_back(e.value);
+        });
+        std::vector<int> expected;
+        for (std::size_t i = routing.size(); i > 0; --i) {
+            if (routing[i - 1].start < start + 0x1000UL && routing[i - 1].end > start) {
+                expected.push_back(routing[i - 1].value);
+            }
+        }
+        assert(visited == expected);
+    }
+
+    std::vector<int> values;
+    table.overlapSearch(0x3fffffffUL, 0x40001001UL, [&values](const StaticEntry<unsigned long, int>& e) {
+        values.push_back(e.value);
+    });
+    assert(values.size() == 2 && values[0] == 4 && values[1] == 3);
+}
+
+/**
+ * The tree lives in a buffer, nothing may come from the default resource.
+ */
+void pmrIntervalTree_Test() {
+    typedef IntervalT<unsigned long> Interval;
+
+    static unsigned char buffer[1 << 16];
+    std::pmr::memory_resource* previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    std::pmr::monotonic_buffer_resource request(buffer, sizeof buffer, std::pmr::null_memory_resource());
+    {
+        PmrIntervalTree<unsigned long> it(&request);
+        for (unsigned long i = 0; i < 500; ++i) {
+            assert(it.insert(Interval::valueOf((i * 37) % 500 * 10, (i * 37) % 500 * 10 + 15)));
+        }
+        assert(it.isValid());
+        assert(it.get_allocator().resource() == &request);
+
+        std::set<Interval> res;
+        it.overlapSearch(Interval::valueOf(100, 120), res);
+        assert(res.size() == 3);
+
+        std::size_t count = 0;
+        it.forEach([&count](const Interval&) {
+            ++count;
+        });
+        assert(count == 500);
+
+        /**
+         * the nodes of another resource are copied into the buffer.
+         */
+        PmrIntervalTree<unsigned long> other(std::pmr::new_delete_resource());
+        other.insert(Interval::valueOf(7, 9));
+        it = std::move(other);
+        assert(other.empty());
+        assert(it.get_allocator().resource() == &request);
+        assert(it.search(7).isValid() && !it.search(10).isValid());
+    }
+    std::pmr::set_default_resource(previous);
+}
+
+int main() {
+    staticIntervalTable_Test();
+    pmrIntervalTree_Test();
+    return 0;
+}
@@ -1,12 +1,29 @@
 #include <iostream>
 #include <sstream>
 #include <set>
+#include <map>
 #include <exception>
+#include <new>
 #include <cassert>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
 
 #include <Interval.hpp>
 #include <IntervalTree.hpp>
+#include <ConcurrentIntervalTree.hpp>
+#include <PersistentIntervalTree.hpp>
+#include <IntervalBTree.hpp>
+#include <IntervalCoverage.hpp>
+#include <IntrusiveIntervalTree.hpp>
+#include <OccupancyBitmap.hpp>
+#include <OverlapCache.hpp>
+#include <NestedContainmentList.hpp>
+#include <overlap_join.hpp>
 #include <interval_operations.hpp>
+#include <interval_algebra.hpp>
 
 /**
  * User defined Interval.
@@ -54,6 +71,180 @@ inline std::ostream& operator <<(std::ostream &out, const ExtentT<T>& i) {
     return out;
 }
 
+/**
+ * User defined Interval that counts its copies.
+ * Once copies reaches a non-negative limit the next copy construction throws.
+ */
+class CountingExtent {
+private:
+    unsigned long start_;
+    unsigned long end_;
+    char descriptor_[48];
+public:
+    static int copies;
+    static int limit;
+
+    CountingExtent(): start_(0UL), end_(0UL), descriptor_() {}
+    CountingExtent(unsigned long start, unsigned long end): start_(start), end_(end), descriptor_() {}
+    CountingExtent(const CountingExtent& other): start_(other.start_), end_(other.end_), descriptor_() {
+        if (limit >= 0 && copies >= limit) {
+            throw std::bad_alloc();
+        }
+        ++copies;
+    }
+    CountingExtent(CountingExtent&& other): start_(other.start_), end_(other.end_), descriptor_() {}
+    CountingExtent& operator=(const CountingExtent& other) {
+        start_ = other.start_;
+        end_ = other.end_;
+        ++copies;
+        return *this;
+    }
+    CountingExtent& operator=(CountingExtent&& other) {
+        start_ = other.start_;
+        end_ = other.end_;
+        return *this;
+    }
+    unsigned long start() const {
+        return start_;
+    }
+    unsigned long end() const {
+        return end_;
+    }
+    bool isValid() const {
+        return end_ > start_;
+    }
+};
+
+int CountingExtent::copies = 0;
+int CountingExtent::limit = -1;
+
+inline std::ostream& operator <<(std::ostream &out, const CountingExtent& i) {
+    out << "[" << i.start() << "," << i.end() << "[";
+    return out;
+}
+
+/**
+ * Blocks handed out by ArenaAllocator.
+ */
+struct Arena {
+    long allocations;
+    long live;
+
+    Arena(): allocations(0L), live(0L) {}
+};
+
+/**
+ * Stateful allocator, allocators of different arenas are not equal and do not propagate.
+ */
+template<typename U>
+class ArenaAllocator {
+public:
+    typedef U value_type;
+
+    Arena* arena;
+
+    explicit ArenaAllocator(Arena* a): arena(a) {}
+    template<typename V>
+    ArenaAllocator(const ArenaAllocator<V>& other): arena(other.arena) {}
+
+    U* allocate(std::size_t n) {
+        ++arena->allocations;
+        ++arena->live;
+        return static_cast<U*>(::operator new(n * sizeof(U)));
+    }
+    void deallocate(U* p, std::size_t) {
+        --arena->live;
+        ::operator delete(p);
+    }
+
+    /**
+     * members, the comparison templates of interval_operations.hpp accept any type.
+     */
+    bool operator==(const ArenaAllocator& other) const {
+        return arena == other.arena;
+    }
+    bool operator!=(const ArenaAllocator& other) const {
+        return arena != other.arena;
+    }
+};
+
+/**
+ * Augmentations of IntervalTree: total and maximal length of the intervals in a subtree.
+ */
+struct SumLength {
+    typedef unsigned long value_type;
+
+    static value_type identity() {
+        return 0UL;
+    }
+    static value_type value(const IntervalT<unsigned long>& key) {
+        return key.end() - key.start();
+    }
+    static value_type combine(value_type a, value_type b) {
+        return a + b;
+    }
+};
+
+struct MaxLength {
+    typedef unsigned long value_type;
+
+    static value_type identity() {
+        return 0UL;
+    }
+    static value_type value(const IntervalT<unsigned long>& key) {
+        return key.end() - key.start();
+    }
+    static value_type combine(value_type a, value_type b) {
+        return std::max(a, b);
+    }
+};
+
+/**
+ * The minimal end that counts the refreshes of aggregates, the nodes an operation touches.
+ */
+struct CountMinEnd: MinEndAugmentation<unsigned long> {
+    static unsigned long calls;
+
+    static value_type combine(value_type a, value_type b) {
+        ++calls;
+        return MinEndAugmentation<unsigned long>::combine(a, b);
+    }
+};
+
+unsigned long CountMinEnd::calls = 0UL;
+
+/**
+ * User defined Interval linked by IntrusiveIntervalTree.
+ */
+struct HookedExtent: IntrusiveIntervalHook<unsigned long, HookedExtent> {
+    unsigned long start_;
+    unsigned long end_;
+
+    HookedExtent(): start_(0UL), end_(0UL) {}
+
+    unsigned long start() const {
+        return start_;
+    }
+    unsigned long end() const {
+        return end_;
+    }
+};
+
+/**
+ * Item of IntrusiveIntervalTree with signed coordinates.
+ */
+struct SignedHookedExtent: IntrusiveIntervalHook<long, SignedHookedExtent> {
+    long start_;
+    long end_;
+
+    long start() const {
+        return start_;
+    }
+    long end() const {
+        return end_;
+    }
+};
+
 /**
  * Test with default Interval.
  */
@@ -630,6 +821,104 @@ void interval_set_union_Test1() {
     }
 }
 
+void interval_algebra_Test() {
+    typedef unsigned long IntType;
+    typedef std::vector<IntType> Bounds;
+    typedef IntervalList<const IntType> List;
+
+    /**
+     * a normalized list is the only one of its set of points: the results are compared
+     * with the lists made of the points counted by brute force.
+     */
+    struct Check {
+        static List view(const Bounds& starts, const Bounds& ends) {
+            return List{starts.data(), ends.data(), starts.size()};
+        }
+        static void points(const Bounds& starts, const Bounds& ends, std::vector<bool>& covered) {
+            for (std::size_t k = 0; k < starts.size(); ++k) {
+                for (IntType x = starts[k]; x < ends[k]; ++x) {
+                    covered[x] = true;
+                }
+            }
+        }
+        static void same(const Bounds& starts, const Bounds& ends, std::size_t n, const std::vector<bool>& covered) {
+            Bounds s, e;
+            for (IntType x = 0; x < covered.size(); ++x) {
+                if (covered[x] && (x == 0 || !covered[x - 1])) {
+                    s.push_back(x);
+                }
+                if (covered[x] && (x + 1 == covered.size() || !covered[x + 1])) {
+                    e.push_back(x + 1);
+                }
+            }
+            assert(n == s.size());
+            assert(std::equal(s.begin(), s.end(), starts.begin()) && std::equal(e.begin(), e.end(), ends.begin()));
+        }
+    };
+
+    const IntType space = 3000;
+    std::srand(50);
+    for (int round = 0; round < 200; ++round) {
+        Bounds lists[2][2];
+        std::vector<bool> covered[2];
+        for (int l = 0; l < 2; ++l) {
+            std::size_t size = std::rand() % 120;
+            IntType length = 1 + std::rand() % (round % 2 == 0 ? 8 : 60);
+            std::vector<std::pair<IntType, IntType>> raw;
+            for (std::size_t k = 0; k < size; ++k) {
+                IntType start = std::rand() % (space - 100);
+                raw.push_back(std::make_pair(start, start + std::rand() % length));
+            }
+            std::sort(raw.begin(), raw.end());
+            Bounds& starts = lists[l][0];
+            Bounds& ends = lists[l][1];
+            for (auto& r: raw) {
+                starts.push_back(r.first);
+                ends.push_back(r.second);
+            }
+            covered[l].assign(space, false);
+            Check::points(starts, ends, covered[l]);
+            std::size_t n = sorted_normalize(starts.data(), ends.data(), starts.size());
+            starts.resize(n);
+            ends.resize(n);
+            Check::same(starts, ends, n, covered[l]);
+        }
+        List a = Check::view(lists[0][0], lists[0][1]);
+        List b = Check::view(lists[1][0], lists[1][1]);
+        Bounds starts(a.size + b.size + 1), ends(a.size + b.size + 1);
+        std::vector<bool> expected(space);
+
+        for (IntType x = 0; x < space; ++x) {
+            expected[x] = covered[0][x] || covered[1][x];
+        }
+        Check::same(starts, ends, sorted_union(a, b, starts.data(), ends.data()), expected);
+        for (IntType x = 0; x < space; ++x) {
+            expected[x] = covered[0][x] && covered[1][x];
+        }
+        Check::same(starts, ends, sorted_intersect(a, b, starts.data(), ends.data()), expected);
+        for (IntType x = 0; x < space; ++x) {
+            expected[x] = covered[0][x] && !covered[1][x];
+        }
+        Check::same(starts, ends, sorted_difference(a, b, starts.data(), ends.data()), expected);
+        IntType lo = std::rand() % space, hi = lo + std::rand() % (space - lo);
+        for (IntType x = 0; x < space; ++x) {
+            expected[x] = lo <= x && x < hi && !covered[0][x];
+        }
+        Check::same(starts, ends, sorted_complement(a, lo, hi, starts.data(), ends.data()), expected);
+    }
+
+    /**
+     * long runs go in blocks.
+     */
+    Bounds starts, ends;
+    for (IntType k = 0; k < 1000; ++k) {
+        starts.push_back(k * 3);
+        ends.push_back(k * 3 + (k == 500 ? 4 : 2));
+    }
+    assert(sorted_normalize(IntervalList<IntType>{starts.data(), ends.data(), starts.size()}) == 999);
+    assert(ends[500] == 1505 && starts[501] == 1506);
+}
+
 void intervalTree_Test() {
     using std::set;
     using std::cout;
@@ -672,6 +961,1519 @@ void intervalTree_Test() {
     }
 }
 
+void intervalTree_clone_move_Test() {
+    using std::ostringstream;
+    using std::set;
+    using std::vector;
+
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+
+    IntervalTree<IntType> it;
+    for (IntType i = 0; i < 100; ++i) {
+        it.insert(Interval::valueOf((i * 37) % 100, (i * 37) % 100 + 5));
+    }
+
+    /**
+     * the copy has the same structure, colors and augmentation.
+     */
+    IntervalTree<IntType> copy = it.clone();
+    ostringstream original, copied;
+    original << HierarchyWriter<IntType>(it);
+    copied << HierarchyWriter<IntType>(copy);
+    assert(original.str() == copied.str());
+
+    copy.remove(Interval::valueOf(50, 55));
+    assert(it.search(50).isValid());
+    assert(!copy.search(50).isValid());
+
+    /**
+     * move hands the nodes over.
+     */
+    IntervalTree<IntType> moved(std::move(copy));
+    assert(copy.empty());
+    assert(!moved.empty());
+    copy = std::move(moved);
+    assert(moved.empty());
+    set<Interval> res;
+    copy.overlapSearch(Interval::valueOf(48, 56), res);
+    assert(res.size() == 11);
+
+    vector<IntervalTree<IntType>> trees;
+    trees.push_back(it.clone());
+    trees.push_back(std::move(it));
+    assert(it.empty());
+    assert(trees[1].search(50).isValid());
+}
+
+void intervalTree_remove_Test() {
+    using std::set;
+
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+
+    IntervalTree<IntType> it;
+    set<IntType> starts;
+    std::srand(3);
+    for (int i = 0; i < 20000; ++i) {
+        IntType start = std::rand() % 2000;
+        Interval interval = Interval::valueOf(start, start + 1 + std::rand() % 100);
+        if (std::rand() % 2 == 0) {
+            assert(it.remove(interval) == (starts.erase(start) == 1));
+        } else {
+            assert(it.insert(interval) == starts.insert(start).second);
+        }
+        if (i % 1000 == 0) {
+            assert(it.isValid());
+        }
+    }
+    assert(it.isValid());
+    for (IntType start = 0; start < 2000; ++start) {
+        assert(it.search(start).isValid() == (starts.count(start) == 1));
+    }
+}
+
+void intervalTree_emplace_Test() {
+    typedef unsigned long IntType;
+    typedef CountingExtent Interval;
+
+    IntervalTree<IntType, Interval> it;
+    CountingExtent::copies = 0;
+    for (IntType i = 0; i < 100; ++i) {
+        IntType start = (i * 37) % 100;
+        if (i % 2 == 0) {
+            assert(it.emplace(start, start + 5));
+        } else {
+            assert(it.insert(Interval(start, start + 5)));
+        }
+    }
+    assert(it.isValid());
+    assert(!it.emplace(37UL, 40UL));
+    assert(!it.insert(Interval(37, 40)));
+    for (IntType i = 0; i < 100; i += 3) {
+        assert(it.remove(Interval(i, i + 5)));
+    }
+    assert(CountingExtent::copies == 0);
+    assert(it.isValid());
+
+    for (IntType i = 0; i < 100; ++i) {
+        assert(it.search(i).isValid() == (i % 3 != 0));
+    }
+    assert(it.search(Interval(37, 40)).end() == 42);
+
+    /**
+     * lvalues are still copied once.
+     */
+    Interval key(500, 505);
+    assert(it.insert(key));
+    assert(CountingExtent::copies == 1);
+}
+
+void intervalTree_allocator_Test() {
+    using std::set;
+
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+    typedef ArenaAllocator<Interval> Allocator;
+    typedef IntervalTree<IntType, Interval, Allocator> Tree;
+
+    Arena arena, other;
+    {
+        Tree it{Allocator(&arena)};
+        for (IntType i = 0; i < 100; ++i) {
+            it.insert(Interval::valueOf((i * 37) % 100, (i * 37) % 100 + 5));
+        }
+        assert(arena.live == 100);
+        assert(it.remove(Interval::valueOf(50, 55)));
+        assert(arena.live == 99);
+
+        /**
+         * the stack of the search comes from the arena too.
+         */
+        long allocations = arena.allocations;
+        set<Interval> res;
+        it.overlapSearch(Interval::valueOf(48, 56), res);
+        assert(res.size() == 11);
+        assert(arena.allocations > allocations);
+        assert(arena.live == 99);
+
+        Tree copy = it.clone(Allocator(&other));
+        assert(other.live == 99);
+        assert(copy.isValid());
+        Tree moved(std::move(copy));
+        assert(moved.get_allocator() == Allocator(&other));
+
+        /**
+         * the allocators differ and do not propagate, the intervals are copied into the arena.
+         */
+        it = std::move(moved);
+        assert(moved.empty());
+        assert(other.live == 0);
+        assert(arena.live == 99);
+        assert(it.isValid());
+        assert(it.search(55).isValid() && !it.search(50).isValid());
+    }
+    assert(arena.live == 0);
+    assert(other.live == 0);
+}
+
+void intervalTree_batch_Test() {
+    using std::set;
+    using std::vector;
+
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+
+    IntervalTree<IntType> it;
+    std::srand(7);
+    for (int i = 0; i < 5000; ++i) {
+        IntType start = std::rand() % 100000;
+        it.insert(Interval::valueOf(start, start + 1 + (i % 50 == 0 ? std::rand() % 20000 : std::rand() % 100)));
+    }
+    vector<Interval> queries;
+    for (int i = 0; i < 1000; ++i) {
+        IntType start = std::rand() % 110000;
+        queries.push_back(Interval::valueOf(start, start + 1 + std::rand() % 200));
+    }
+
+    /**
+     * one search at a time, more searches than queries, and between.
+     */
+    std::size_t groups[] = {1, 16, 5000};
+    for (std::size_t group: groups) {
+        vector<set<Interval>> res(queries.size());
+        it.batchOverlapSearch(queries.begin(), queries.end(), [&res](std::size_t query, const Interval& i) {
+            assert(res[query].insert(i).second);
+        }, group);
+        for (std::size_t q = 0; q < queries.size(); ++q) {
+            set<Interval> expected;
+            it.overlapSearch(queries[q], expected);
+            assert(res[q] == expected);
+        }
+    }
+
+    IntervalTree<IntType> empty;
+    empty.batchOverlapSearch(queries.begin(), queries.end(), [](std::size_t, const Interval&) {
+        assert(false);
+    });
+}
+
+void intervalTree_vector_Test() {
+    using std::set;
+    using std::vector;
+
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+
+    IntervalTree<IntType> it;
+    std::srand(11);
+    for (int i = 0; i < 5000; ++i) {
+        IntType start = std::rand() % 100000;
+        it.insert(Interval::valueOf(start, start + 1 + (i % 50 == 0 ? std::rand() % 20000 : std::rand() % 100)));
+    }
+
+    vector<Interval> res;
+    vector<const Interval*> pointers;
+    for (int i = 0; i < 1000; ++i) {
+        IntType start = std::rand() % 110000;
+        Interval query = Interval::valueOf(start, start + 1 + std::rand() % 200);
+        set<Interval> expected;
+        it.overlapSearch(query, expected);
+
+        /**
+         * in the order of starts, no sort or dedup needed.
+         */
+        res.clear();
+        it.overlapSearch(query, res);
+        assert(res.size() == expected.size());
+        assert(std::equal(res.begin(), res.end(), expected.begin()));
+
+        pointers.clear();
+        it.overlapSearch(query, pointers);
+        assert(pointers.size() == expected.size());
+        for (std::size_t k = 0; k < pointers.size(); ++k) {
+            assert(pointers[k] == &it.search(*pointers[k]));
+            assert(*pointers[k] == res[k]);
+        }
+    }
+
+    /**
+     * res is appended to.
+     */
+    std::size_t size = 0;
+    it.forEach([&size](const Interval&) {
+        ++size;
+    });
+    res.assign(1, Interval::valueOf(1, 2));
+    it.overlapSearch(Interval::valueOf(0, 200000), res);
+    assert(res.size() == size + 1);
+    assert(res[0] == Interval::valueOf(1, 2));
+}
+
+void intervalTree_expire_Test() {
+    using std::map;
+
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+
+    /**
+     * a stream of intervals, mostly short, some long, the watermark follows the stream.
+     */
+    IntervalTree<IntType, Interval, std::allocator<Interval>, MinEndAugmentation<IntType>> it;
+    map<IntType, IntType> model;
+    std::srand(13);
+    IntType now = 0;
+    for (int round = 0; round < 200; ++round) {
+        for (int i = 0; i < 100; ++i) {
+            IntType start = now + std::rand() % 50;
+            IntType end = start + 1 + (std::rand() % 20 == 0 ? std::rand() % 2000 : std::rand() % 30);
+            assert(it.insert(Interval::valueOf(start, end)) == model.insert(std::make_pair(start, end)).second);
+            now += std::rand() % 3;
+        }
+        IntType watermark = now - std::rand() % 40;
+        std::size_t expected = 0;
+        for (map<IntType, IntType>::iterator j = model.begin(); j != model.end();) {
+            if (j->second <= watermark) {
+                model.erase(j++);
+                ++expected;
+            } else {
+                ++j;
+            }
+        }
+        assert(it.expireBefore(watermark) == expected);
+        assert(it.isValid());
+        std::size_t size = 0;
+        it.forEach([&](const Interval& i) {
+            assert(model.count(i.start()) == 1 && model[i.start()] == i.end());
+            ++size;
+        });
+        assert(size == model.size());
+    }
+
+    /**
+     * everything expires, nothing expires.
+     */
+    assert(it.expireBefore(now + 5000) == model.size());
+    assert(it.empty());
+    assert(it.expireBefore(now) == 0);
+    assert(it.insert(Interval::valueOf(10, 20)));
+    assert(it.expireBefore(10) == 0);
+    assert(it.expireBefore(20) == 1);
+    assert(it.empty());
+
+    /**
+     * one interval expires among live ones all starting before the watermark:
+     * the nodes touched do not grow with the number of the live ones.
+     */
+    unsigned long touched[2];
+    IntType sizes[2] = {1000, 100000};
+    for (int t = 0; t < 2; ++t) {
+        IntervalTree<IntType, Interval, std::allocator<Interval>, CountMinEnd> live;
+        for (IntType k = 0; k < sizes[t]; ++k) {
+            assert(live.insert(Interval::valueOf(10 * k, 1000000000 + k)));
+        }
+        assert(live.insert(Interval::valueOf(5 * sizes[t] + 5, 5 * sizes[t] + 6)));
+        CountMinEnd::calls = 0UL;
+        assert(live.expireBefore(10 * sizes[t]) == 1);
+        touched[t] = CountMinEnd::calls;
+        assert(live.isValid());
+    }
+    assert(touched[1] < 2 * touched[0] + 100);
+}
+
+void intervalTree_split_join_Test() {
+    using std::vector;
+
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+
+    IntervalTree<IntType> it;
+    vector<Interval> all;
+    for (IntType i = 0; i < 1000; ++i) {
+        it.insert(Interval::valueOf((i * 7919) % 1000 * 3, (i * 7919) % 1000 * 3 + 10));
+    }
+    it.forEach([&all](const Interval& i) {
+        all.push_back(i);
+    });
+
+    IntType cuts[] = {0, 1, 2, 3, 4, 1500, 1501, 2996, 2997, 2998, 5000};
+    for (IntType at: cuts) {
+        IntervalTree<IntType> right = it.split(at);
+        assert(it.isValid() && right.isValid());
+        std::size_t count = 0;
+        it.forEach([&](const Interval& i) {
+            assert(i.start() < at);
+            assert(i == all[count++]);
+        });
+        right.forEach([&](const Interval& i) {
+            assert(i.start() >= at);
+            assert(i == all[count++]);
+        });
+        assert(count == all.size());
+
+        /**
+         * the right part may not go first.
+         */
+        if (!it.empty() && !right.empty()) {
+            bool thrown = false;
+            try {
+                IntervalTree<IntType>::join(std::move(right), std::move(it));
+            } catch (std::invalid_argument&) {
+                thrown = true;
+            }
+            assert(thrown && !it.empty() && !right.empty());
+        }
+
+        it = IntervalTree<IntType>::join(std::move(it), std::move(right));
+        assert(right.empty());
+        assert(it.isValid());
+        count = 0;
+        it.forEach([&](const Interval& i) {
+            assert(i == all[count++]);
+        });
+        assert(count == all.size());
+    }
+
+    /**
+     * trees of very different heights.
+     */
+    IntervalTree<IntType> small;
+    small.insert(Interval::valueOf(5000, 5001));
+    it = IntervalTree<IntType>::join(std::move(it), std::move(small));
+    assert(it.isValid() && it.search(5000).isValid());
+    small.insert(Interval::valueOf(0, 1));
+    IntervalTree<IntType> rest = it.split(1);
+    it = IntervalTree<IntType>::join(std::move(small), std::move(rest));
+    assert(it.isValid() && it.search(0UL).isValid() && it.search(3).isValid());
+
+    /**
+     * the joins of a split telescope: the nodes walked along spines grow as log n,
+     * not as log^2 n (about 2.9 times from 1000 to 100000 intervals).
+     */
+    unsigned long walked[2];
+    IntType sizes[2] = {1000, 100000};
+    for (int t = 0; t < 2; ++t) {
+        IntervalTree<IntType> tree;
+        for (IntType i = 0; i < sizes[t]; ++i) {
+            tree.insert(Interval::valueOf((i * 7919) % sizes[t] * 10, (i * 7919) % sizes[t] * 10 + 5));
+        }
+        walked[t] = 0;
+        std::srand(37);
+        for (int round = 0; round < 100; ++round) {
+            unsigned long before = tree.spineSteps();
+            IntervalTree<IntType> right = tree.split(std::rand() % (sizes[t] * 10));
+            walked[t] += tree.spineSteps() - before + right.spineSteps();
+            tree = IntervalTree<IntType>::join(std::move(tree), std::move(right));
+        }
+        assert(tree.isValid());
+    }
+    assert(walked[1] < 2 * walked[0]);
+}
+
+void intervalTree_merge_Test() {
+    using std::map;
+
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+    typedef map<IntType, IntType> Model;
+
+    struct Check {
+        static void same(const IntervalTree<IntType>& it, const Model& model) {
+            assert(it.isValid());
+            Model::const_iterator j = model.begin();
+            it.forEach([&j, &model](const Interval& i) {
+                assert(j != model.end() && j->first == i.start() && j->second == i.end());
+                ++j;
+            });
+            assert(j == model.end());
+        }
+    };
+
+    std::srand(17);
+    for (int round = 0; round < 20; ++round) {
+        IntervalTree<IntType> a, b;
+        Model ma, mb;
+        int na = std::rand() % 500, nb = std::rand() % 500;
+        for (int i = 0; i < na; ++i) {
+            IntType start = std::rand() % 1000;
+            IntType end = start + 1 + std::rand() % 5;
+            assert(a.insert(Interval::valueOf(start, end)) == ma.insert(std::make_pair(start, end)).second);
+        }
+        for (int i = 0; i < nb; ++i) {
+            IntType start = std::rand() % 1000;
+            IntType end = start + 1 + std::rand() % 5;
+            assert(b.insert(Interval::valueOf(start, end)) == mb.insert(std::make_pair(start, end)).second);
+        }
+
+        /**
+         * intervals are equal if they have the same start, the intervals of a stay.
+         */
+        Model common, only;
+        for (Model::iterator i = ma.begin(); i != ma.end(); ++i) {
+            (mb.count(i->first) == 1 ? common : only).insert(*i);
+        }
+
+        IntervalTree<IntType> intersection = a.clone();
+        intersection.intersectWith(b);
+        Check::same(intersection, common);
+
+        IntervalTree<IntType> difference = a.clone();
+        difference.subtract(b);
+        Check::same(difference, only);
+
+        Model all = ma;
+        all.insert(mb.begin(), mb.end());
+        a.mergeFrom(std::move(b));
+        assert(b.empty());
+        Check::same(a, all);
+    }
+
+    /**
+     * with itself.
+     */
+    IntervalTree<IntType> it;
+    for (IntType i = 0; i < 10; ++i) {
+        it.insert(Interval::valueOf(i, i + 1));
+    }
+    it.intersectWith(it);
+    it.mergeFrom(std::move(it));
+    assert(it.isValid() && it.search(9).isValid());
+    it.subtract(it);
+    assert(it.empty());
+}
+
+void overlapJoin_Test() {
+    using std::vector;
+    using std::set;
+    using std::pair;
+
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+    typedef pair<IntType, IntType> Pair;
+
+    IntervalTree<IntType> a, b;
+    vector<Interval> va, vb;
+    std::srand(19);
+    for (int i = 0; i < 600; ++i) {
+        IntType start = std::rand() % 10000;
+        Interval interval = Interval::valueOf(start, start + 1 + (i % 40 == 0 ? std::rand() % 3000 : std::rand() % 50));
+        if (a.insert(interval)) {
+            va.push_back(interval);
+        }
+        start = std::rand() % 10000;
+        interval = Interval::valueOf(start, start + 1 + std::rand() % 80);
+        if (b.insert(interval)) {
+            vb.push_back(interval);
+        }
+    }
+
+    /**
+     * pairs by start, starts are unique in a tree.
+     */
+    set<Pair> expected;
+    for (std::size_t i = 0; i < va.size(); ++i) {
+        for (std::size_t j = 0; j < vb.size(); ++j) {
+            if (overlap(va[i], vb[j])) {
+                expected.insert(Pair(va[i].start(), vb[j].start()));
+            }
+        }
+    }
+
+    unsigned threads[] = {1, 3, 8};
+    for (unsigned t: threads) {
+        vector<vector<Pair>> parts(t);
+        overlapJoin(a, b, [&parts](std::size_t part, const Interval& x, const Interval& y) {
+            assert(overlap(x, y));
+            parts[part].push_back(Pair(x.start(), y.start()));
+        }, t);
+        set<Pair> found;
+        std::size_t count = 0;
+        for (std::size_t p = 0; p < parts.size(); ++p) {
+            found.insert(parts[p].begin(), parts[p].end());
+            count += parts[p].size();
+        }
+        assert(count == found.size());
+        assert(found == expected);
+    }
+
+    IntervalTree<IntType> empty;
+    overlapJoin(a, empty, [](std::size_t, const Interval&, const Interval&) {
+        assert(false);
+    }, 4);
+
+    /**
+     * other augmentations and balancing policies.
+     */
+    IntervalTree<IntType, Interval, std::allocator<Interval>, SumLength, AvlBalance> avl;
+    IntervalTree<IntType, Interval, std::allocator<Interval>, NoAugmentation, TreapBalance> treap;
+    for (auto i: va) {
+        avl.insert(i);
+    }
+    for (auto i: vb) {
+        treap.insert(i);
+    }
+    set<Pair> found;
+    overlapJoin(avl, treap, [&found](std::size_t, const Interval& x, const Interval& y) {
+        found.insert(Pair(x.start(), y.start()));
+    });
+    assert(found == expected);
+}
+
+void intervalTree_finger_Test() {
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+    typedef IntervalTree<IntType>::Finger Finger;
+
+    IntervalTree<IntType> it;
+    for (IntType i = 0; i < 2000; ++i) {
+        it.insert(Interval::valueOf((i * 7919) % 2000 * 4, (i * 7919) % 2000 * 4 + 4));
+    }
+
+    /**
+     * sequential reads through the map, forwards and backwards, hits and misses.
+     */
+    Finger finger;
+    for (IntType offset = 0; offset < 8100; ++offset) {
+        assert(it.search(offset, finger).isValid() == it.search(offset).isValid());
+        assert(it.search(offset, finger).end() == it.search(offset).end());
+    }
+    for (IntType offset = 8100; offset-- > 0;) {
+        assert(it.search(offset, finger).isValid() == (offset % 4 == 0 && offset < 8000));
+    }
+    std::srand(23);
+    for (int i = 0; i < 2000; ++i) {
+        IntType offset = std::rand() % 8000;
+        assert(it.search(offset, finger).isValid() == (offset % 4 == 0));
+    }
+
+    /**
+     * the node of the finger is freed, the finger is not used.
+     */
+    assert(it.search(400, finger).isValid());
+    assert(it.remove(Interval::valueOf(400, 404)));
+    assert(!it.search(400, finger).isValid());
+    assert(it.search(404, finger).isValid());
+
+    /**
+     * a finger of another tree is not used.
+     */
+    IntervalTree<IntType> other = it.clone();
+    assert(other.search(404, finger).isValid());
+    IntervalTree<IntType> right = it.split(4000);
+    assert(!it.search(4000, finger).isValid());
+    assert(it.search(3996, finger).isValid());
+    assert(right.search(4000, finger).isValid());
+}
+
+void intrusiveIntervalTree_Test() {
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+
+    /**
+     * the items live in a slab, the tree only links them.
+     */
+    std::vector<HookedExtent> slab(1000);
+    std::vector<bool> linked(slab.size(), false);
+    IntrusiveIntervalTree<IntType, HookedExtent> it;
+    std::srand(29);
+    for (std::size_t k = 0; k < slab.size(); ++k) {
+        slab[k].start_ = k * 10;
+        slab[k].end_ = k * 10 + 1 + std::rand() % (k % 50 == 0 ? 2000 : 30);
+    }
+    for (int step = 0; step < 20000; ++step) {
+        std::size_t k = std::rand() % slab.size();
+        if (linked[k]) {
+            it.remove(slab[k]);
+        } else {
+            assert(it.insert(slab[k]));
+        }
+        linked[k] = !linked[k];
+        if (step % 1000 == 0) {
+            assert(it.isValid());
+        }
+    }
+    assert(it.isValid());
+
+    /**
+     * the end of a linked item changed behind the tree: the check reports it and
+     * keeps reporting it, it does not write the items.
+     */
+    std::size_t changed = std::find(linked.begin(), linked.end(), true) - linked.begin();
+    slab[changed].end_ += 5000;
+    assert(!it.isValid());
+    assert(!it.isValid());
+    slab[changed].end_ -= 5000;
+    assert(it.isValid());
+
+    /**
+     * queries return the items themselves.
+     */
+    for (int q = 0; q < 500; ++q) {
+        IntType start = std::rand() % 10100;
+        Interval window = Interval::valueOf(start, start + std::rand() % 100);
+        std::vector<HookedExtent*> expected, res;
+        for (std::size_t k = 0; k < slab.size(); ++k) {
+            if (linked[k] && slab[k].start() < window.end() && window.start() < slab[k].end()) {
+                expected.push_back(&slab[k]);
+            }
+        }
+        it.overlapSearch(window, res);
+        assert(res == expected);
+    }
+    for (std::size_t k = 0; k < slab.size(); ++k) {
+        assert(it.search(k * 10) == (linked[k] ? &slab[k] : nullptr));
+        assert(it.search(k * 10 + 1) == nullptr);
+    }
+
+    /**
+     * the same start is refused, a copy of a linked item is not linked.
+     */
+    HookedExtent duplicate;
+    duplicate.start_ = 0;
+    duplicate.end_ = 5;
+    assert(!linked[0] || !it.insert(duplicate));
+    HookedExtent copy = slab[0];
+    assert(it.search(0) != &copy);
+
+    std::size_t count = 0;
+    IntType last = 0;
+    it.forEach([&](HookedExtent& e) {
+        assert(count == 0 || last < e.start());
+        last = e.start();
+        ++count;
+    });
+    assert(count == static_cast<std::size_t>(std::count(linked.begin(), linked.end(), true)));
+
+    IntrusiveIntervalTree<IntType, HookedExtent> moved(std::move(it));
+    assert(it.empty() && moved.isValid());
+    for (std::size_t k = 0; k < slab.size(); ++k) {
+        if (linked[k]) {
+            moved.remove(slab[k]);
+        }
+    }
+    assert(moved.empty() && moved.isValid());
+
+    /**
+     * the augmentation and search use the coordinate type of the tree.
+     */
+    IntrusiveIntervalTree<long, SignedHookedExtent> signedTree;
+    std::vector<SignedHookedExtent> signedSlab(20);
+    for (long k = 0; k < 20; ++k) {
+        signedSlab[k].start_ = (k - 10) * 10;
+        signedSlab[k].end_ = (k - 10) * 10 + 15;
+        assert(signedTree.insert(signedSlab[k]));
+    }
+    assert(signedTree.isValid());
+    assert(signedTree.search(-50L) == &signedSlab[5]);
+    std::vector<SignedHookedExtent*> signedRes;
+    SignedHookedExtent query;
+    query.start_ = -25;
+    query.end_ = -15;
+    signedTree.overlapSearch(query, signedRes);
+    assert(signedRes.size() == 2 && signedRes[0]->start() == -30L && signedRes[1]->start() == -20L);
+}
+
+void intervalTree_handle_Test() {
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+    typedef IntervalTree<IntType>::Handle Handle;
+
+    IntervalTree<IntType> it;
+    std::map<IntType, IntType> model;
+    for (IntType i = 0; i < 1000; ++i) {
+        IntType start = (i * 7919) % 1000 * 10;
+        it.insert(Interval::valueOf(start, start + 5));
+        model[start] = start + 5;
+    }
+    assert(!it.find(3).isValid());
+    Handle h = it.find(420);
+    assert(h.isValid() && h->start() == 420 && (*h).end() == 425);
+    assert(h == it.find(420) && h != it.find(430));
+
+    /**
+     * extents grow in place, max follows.
+     */
+    std::srand(31);
+    for (int step = 0; step < 3000; ++step) {
+        IntType start = std::rand() % 1000 * 10;
+        Handle g = it.find(start);
+        IntType end = start + std::rand() % (step % 100 == 0 ? 5000 : 20);
+        it.updateEnd(g, end);
+        model[start] = end;
+        assert(g->end() == end);
+    }
+    assert(it.isValid());
+    try {
+        it.updateEnd(h, 419);
+        assert(false);
+    } catch (const std::invalid_argument&) {
+    }
+
+    /**
+     * handles of a query are erased without a search, the others stay valid.
+     */
+    std::vector<Handle> handles;
+    Interval window = Interval::valueOf(3000, 6000);
+    it.overlapSearch(window, handles);
+    for (auto& m: model) {
+        bool expected = m.first < window.end() && window.start() < m.second;
+        assert(expected == (std::find(handles.begin(), handles.end(), it.find(m.first)) != handles.end()));
+    }
+    Handle kept = it.find(9990);
+    for (std::size_t k = 0; k < handles.size(); ++k) {
+        model.erase(handles[k]->start());
+        it.erase(handles[k]);
+        if (k % 50 == 0) {
+            assert(it.isValid());
+        }
+    }
+    assert(it.isValid());
+    assert(kept == it.find(9990) && kept->end() == model[9990]);
+    std::vector<Interval> res;
+    it.forEach([&res](const Interval& i) {
+        res.push_back(i);
+    });
+    assert(res.size() == model.size());
+    for (auto& i: res) {
+        assert(model[i.start()] == i.end());
+    }
+}
+
+void intervalCoverage_Test() {
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+
+    /**
+     * the index against a brute force count per unit of a small space.
+     */
+    const IntType space = 300;
+    IntervalCoverage<IntType> coverage;
+    std::vector<Interval> inserted;
+    std::vector<int> counts(space, 0);
+    std::srand(37);
+    for (int step = 0; step < 3000; ++step) {
+        if (!inserted.empty() && std::rand() % 3 == 0) {
+            std::size_t k = std::rand() % inserted.size();
+            assert(coverage.remove(inserted[k]) == (inserted[k].start() < inserted[k].end()));
+            for (IntType x = inserted[k].start(); x < inserted[k].end(); ++x) {
+                --counts[x];
+            }
+            inserted[k] = inserted.back();
+            inserted.pop_back();
+        } else {
+            IntType start = std::rand() % (space - 40);
+            Interval i = Interval::valueOf(start, start + std::rand() % 40);
+            coverage.insert(i);
+            inserted.push_back(i);
+            for (IntType x = i.start(); x < i.end(); ++x) {
+                ++counts[x];
+            }
+        }
+        if (step % 10 == 0) {
+            IntType a = std::rand() % space;
+            IntType b = a + std::rand() % (space - a);
+            IntType expected = 0;
+            for (IntType x = a; x < b; ++x) {
+                expected += counts[x] > 0 ? 1 : 0;
+            }
+            assert(coverage.coveredLength(Interval::valueOf(a, b)) == expected);
+            assert(coverage.depth(a) == counts[a]);
+            if (a < b) {
+                IntType peakAt = a;
+                for (IntType x = a; x < b; ++x) {
+                    peakAt = counts[x] > counts[peakAt] ? x : peakAt;
+                }
+                IntType at = 0;
+                assert(coverage.maxDepth(Interval::valueOf(a, b), at) == counts[peakAt]);
+                assert(at == peakAt);
+            }
+        }
+    }
+    assert(!coverage.remove(Interval::valueOf(space + 1, space + 2)));
+    assert(coverage.coveredLength(Interval::valueOf(0, 0)) == 0);
+
+    for (auto& i: inserted) {
+        assert(coverage.remove(i) == (i.start() < i.end()));
+    }
+    assert(coverage.empty());
+    coverage.insert(Interval::valueOf(10, 20));
+    coverage.insert(Interval::valueOf(15, 30));
+    coverage.insert(Interval::valueOf(40, 50));
+    assert(coverage.coveredLength(Interval::valueOf(0, 100)) == 30);
+    assert(coverage.coveredLength(Interval::valueOf(18, 45)) == 17);
+    assert(coverage.coveredLength(Interval::valueOf(31, 39)) == 0);
+    IntType at = 0;
+    assert(coverage.maxDepth(Interval::valueOf(0, 100), at) == 2 && at == 15);
+    assert(coverage.maxDepth(Interval::valueOf(20, 100), at) == 1 && at == 20);
+    assert(coverage.maxDepth(Interval::valueOf(31, 39), at) == 0 && at == 31);
+    assert(coverage.maxDepth(Interval::valueOf(5, 5)) == 0);
+
+    /**
+     * both endpoints are indexed, the interval is not.
+     */
+    coverage.clear();
+    coverage.insert(Interval::valueOf(0, 5));
+    coverage.insert(Interval::valueOf(10, 20));
+    assert(!coverage.remove(Interval::valueOf(5, 10)));
+    assert(coverage.depth(7) == 0);
+
+    /**
+     * an empty interval is never indexed.
+     */
+    coverage.insert(Interval::valueOf(7, 7));
+    assert(!coverage.remove(Interval::valueOf(7, 7)));
+    assert(!coverage.remove(Interval::valueOf(20, 20)));
+    assert(coverage.coveredLength(Interval::valueOf(0, 20)) == 15);
+}
+
+void occupancyBitmap_Test() {
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+
+    /**
+     * kept alongside the tree, a window the bitmap rejects has no overlaps in the tree.
+     * The buckets cover [1000, 4200), the intervals go beyond it on both sides.
+     */
+    IntervalTree<IntType> tree;
+    OccupancyBitmap<IntType> occupancy(1000, 16, 200);
+    std::vector<Interval> inserted;
+    std::size_t rejected = 0;
+    std::srand(48);
+    for (int step = 0; step < 4000; ++step) {
+        if (!inserted.empty() && std::rand() % 2 == 0) {
+            std::size_t k = std::rand() % inserted.size();
+            assert(tree.remove(inserted[k]) && occupancy.remove(inserted[k]));
+            inserted[k] = inserted.back();
+            inserted.pop_back();
+        } else {
+            IntType start = std::rand() % 5000;
+            Interval i = Interval::valueOf(start, start + std::rand() % 30);
+            if (tree.insert(i)) {
+                occupancy.insert(i);
+                inserted.push_back(i);
+            }
+        }
+        IntType start = std::rand() % 5000;
+        Interval window = Interval::valueOf(start, start + std::rand() % 100);
+        std::vector<Interval> res;
+        tree.overlapSearch(window, res);
+        if (!occupancy.mayOverlap(window)) {
+            assert(res.empty());
+            ++rejected;
+        }
+        if (!inserted.empty()) {
+            assert(occupancy.mayOverlap(inserted[std::rand() % inserted.size()]));
+        }
+    }
+    assert(rejected > 0);
+    for (auto& i: inserted) {
+        assert(occupancy.remove(i));
+    }
+    assert(occupancy.empty() && !occupancy.mayOverlap(Interval::valueOf(0, 10000)));
+
+    /**
+     * the words of the bitmap: a window across several of them, a bucket at a word border.
+     */
+    OccupancyBitmap<IntType> bits(0, 1, 256);
+    bits.insert(Interval::valueOf(127, 129));
+    assert(bits.mayOverlap(Interval::valueOf(0, 256)) && bits.mayOverlap(Interval::valueOf(128, 128)));
+    assert(!bits.mayOverlap(Interval::valueOf(0, 127)) && !bits.mayOverlap(Interval::valueOf(129, 200)));
+    assert(!bits.remove(Interval::valueOf(126, 128)) && bits.remove(Interval::valueOf(127, 129)));
+    bits.insert(Interval::valueOf(64, 64));
+    assert(bits.mayOverlap(Interval::valueOf(63, 65)) && !bits.mayOverlap(Interval::valueOf(65, 66)));
+    bits.clear();
+    assert(bits.empty());
+
+    bool thrown = false;
+    try {
+        OccupancyBitmap<IntType> none(0, 0, 10);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+void overlapCache_Test() {
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+    typedef IntervalTree<IntType> Tree;
+
+    /**
+     * a few hot windows, every kind of change in between: the cached result is always
+     * the one of the tree.
+     */
+    Tree tree;
+    for (IntType k = 0; k < 500; ++k) {
+        tree.insert(Interval::valueOf(k * 10, k * 10 + 1 + k % 25));
+    }
+    OverlapCache<IntType> cache(tree, 4);
+    std::vector<Interval> windows;
+    for (IntType k = 0; k < 6; ++k) {
+        windows.push_back(Interval::valueOf(k * 800, k * 800 + 150));
+    }
+    std::srand(49);
+    for (int step = 0; step < 3000; ++step) {
+        int op = std::rand() % 40;
+        IntType start = std::rand() % 5000;
+        if (op == 0) {
+            tree.insert(Interval::valueOf(start, start + 1 + std::rand() % 30));
+        } else if (op == 1) {
+            tree.remove(tree.search(start));
+        } else if (op == 2) {
+            Tree::Handle h = tree.find(start);
+            if (h.isValid()) {
+                tree.updateEnd(h, h->end() + 3);
+            }
+        } else if (op == 3) {
+            Tree right = tree.split(start);
+            tree = Tree::join(std::move(tree), std::move(right));
+        } else if (op == 4) {
+            Tree other;
+            other.insert(Interval::valueOf(start, start + 5));
+            tree.mergeFrom(std::move(other));
+        }
+        const Interval& window = windows[std::rand() % (op == 5 ? windows.size() : 3)];
+        std::vector<Interval> expected;
+        tree.overlapSearch(window, expected);
+        const std::vector<Interval>& res = cache.overlapSearch(window);
+        assert(res.size() == expected.size());
+        for (std::size_t k = 0; k < res.size(); ++k) {
+            assert(res[k].start() == expected[k].start() && res[k].end() == expected[k].end());
+        }
+        assert(cache.size() <= cache.capacity());
+    }
+    assert(cache.hits() > cache.misses());
+
+    /**
+     * the tree replaced by a move, then emptied.
+     */
+    Tree other;
+    other.insert(windows[0]);
+    tree = std::move(other);
+    assert(cache.overlapSearch(windows[0]).size() == 1);
+    tree.clear();
+    assert(cache.overlapSearch(windows[0]).empty());
+}
+
+void intervalTree_augmentation_Test() {
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+    typedef IntervalTree<IntType, Interval, std::allocator<Interval>, SumLength> SumTree;
+    typedef IntervalTree<IntType, Interval, std::allocator<Interval>, MaxLength> MaxTree;
+
+    /**
+     * the aggregate follows every kind of update.
+     */
+    SumTree it;
+    std::map<IntType, IntType> model;
+    std::srand(41);
+    for (int step = 0; step < 4000; ++step) {
+        IntType start = std::rand() % 5000;
+        Interval i = Interval::valueOf(start, start + 1 + std::rand() % 50);
+        if (std::rand() % 3 == 0) {
+            if (it.remove(i)) {
+                model.erase(start);
+            }
+        } else if (it.insert(i)) {
+            model[start] = i.end();
+        }
+        if (step % 500 == 0 && !model.empty()) {
+            SumTree::Handle h = it.find(model.begin()->first);
+            it.updateEnd(h, h->end() + 7);
+            model[h->start()] = h->end();
+            assert(it.isValid());
+        }
+    }
+    IntType total = 0;
+    for (auto& m: model) {
+        total += m.second - m.first;
+    }
+    assert(it.isValid() && it.aggregate() == total);
+
+    SumTree right = it.split(2500);
+    assert(it.isValid() && right.isValid());
+    assert(it.aggregate() + right.aggregate() == total);
+    SumTree joined = SumTree::join(std::move(it), std::move(right));
+    assert(joined.isValid() && joined.aggregate() == total);
+    SumTree copy = joined.clone();
+    assert(copy.isValid() && copy.aggregate() == joined.aggregate());
+    SumTree empty;
+    assert(empty.aggregate() == 0);
+
+    /**
+     * the long overlapping intervals, pruned by the maximal length of subtrees.
+     */
+    MaxTree lengths;
+    for (IntType k = 0; k < 3000; ++k) {
+        IntType start = k * 10;
+        lengths.insert(Interval::valueOf(start, start + 1 + (k * 7919) % (k % 97 == 0 ? 800 : 30)));
+    }
+    assert(lengths.isValid());
+    for (int q = 0; q < 200; ++q) {
+        IntType start = std::rand() % 30000;
+        Interval window = Interval::valueOf(start, start + std::rand() % 2000);
+        IntType longer = std::rand() % 2 == 0 ? 20 : 100;
+        std::vector<Interval> all, expected, res;
+        lengths.overlapSearch(window, all);
+        for (auto& i: all) {
+            if (i.end() - i.start() > longer) {
+                expected.push_back(i);
+            }
+        }
+        lengths.overlapSearch(window, [longer](IntType length) {
+            return length > longer;
+        }, [&res](const Interval& i) {
+            res.push_back(i);
+        });
+        assert(res.size() == expected.size());
+        for (std::size_t k = 0; k < res.size(); ++k) {
+            assert(res[k].start() == expected[k].start() && res[k].end() == expected[k].end());
+        }
+    }
+}
+
+template<typename Balance>
+void intervalTree_balance_Test(int seed) {
+    using std::map;
+
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+    typedef IntervalTree<IntType, Interval, std::allocator<Interval>, MinEndAugmentation<IntType>, Balance> Tree;
+    typedef map<IntType, IntType> Model;
+
+    struct Check {
+        static void same(const Tree& it, const Model& model) {
+            assert(it.isValid());
+            IntType minEnd = std::numeric_limits<IntType>::max();
+            Model::const_iterator j = model.begin();
+            it.forEach([&j, &model](const Interval& i) {
+                assert(j != model.end() && j->first == i.start() && j->second == i.end());
+                ++j;
+            });
+            assert(j == model.end());
+            for (auto& m: model) {
+                minEnd = std::min(minEnd, m.second);
+            }
+            assert(it.aggregate() == minEnd);
+        }
+    };
+
+    /**
+     * every kind of update keeps the balance of the policy, ascending
+     * insertions are the worst case of an unbalanced tree.
+     */
+    Tree it;
+    Model model;
+    for (IntType k = 0; k < 1000; ++k) {
+        it.insert(Interval::valueOf(k * 10, k * 10 + 5));
+        model[k * 10] = k * 10 + 5;
+    }
+    Check::same(it, model);
+    std::srand(seed);
+    for (int step = 0; step < 6000; ++step) {
+        IntType start = std::rand() % 12000;
+        Interval i = Interval::valueOf(start, start + 1 + std::rand() % 40);
+        int op = std::rand() % 4;
+        if (op == 0) {
+            assert(it.remove(i) == (model.erase(start) == 1));
+        } else if (op == 1) {
+            typename Tree::Handle h = it.find(start);
+            assert(h.isValid() == (model.count(start) == 1));
+            if (h.isValid()) {
+                it.erase(h);
+                model.erase(start);
+            }
+        } else {
+            assert(it.insert(i) == model.insert(std::make_pair(start, i.end())).second);
+        }
+        if (step % 1000 == 0) {
+            Check::same(it, model);
+            std::vector<Interval> res;
+            Interval window = Interval::valueOf(start, start + 500);
+            it.overlapSearch(window, res);
+            std::size_t expected = 0;
+            for (auto& m: model) {
+                expected += m.first < window.end() && window.start() < m.second ? 1 : 0;
+            }
+            assert(res.size() == expected);
+        }
+    }
+    Check::same(it, model);
+
+    /**
+     * split, join, expire and merge rebuild the tree.
+     */
+    Tree right = it.split(6000);
+    Model modelRight(model.lower_bound(6000), model.end());
+    model.erase(model.lower_bound(6000), model.end());
+    Check::same(it, model);
+    Check::same(right, modelRight);
+    Tree joined = Tree::join(std::move(it), std::move(right));
+    model.insert(modelRight.begin(), modelRight.end());
+    Check::same(joined, model);
+
+    /**
+     * subtrees of different heights.
+     */
+    for (IntType at = 100; at < 12000; at += 2300) {
+        Tree tail = joined.split(at);
+        joined = Tree::join(std::move(joined), std::move(tail));
+        Check::same(joined, model);
+    }
+
+    joined.expireBefore(3000);
+    for (Model::iterator m = model.begin(); m != model.end();) {
+        m = m->second <= 3000 ? model.erase(m) : std::next(m);
+    }
+    Check::same(joined, model);
+
+    Tree other;
+    for (IntType k = 0; k < 300; ++k) {
+        IntType start = 12000 + std::rand() % 3000;
+        if (other.insert(Interval::valueOf(start, start + 3))) {
+            model.insert(std::make_pair(start, start + 3));
+        }
+    }
+    joined.mergeFrom(std::move(other));
+    Check::same(joined, model);
+    Tree copy = joined.clone();
+    Check::same(copy, model);
+}
+
+template<typename Tree>
+void intervalBTree_Test(int seed) {
+    using std::set;
+
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+
+    IntervalTree<IntType> expected;
+    Tree it;
+    std::srand(seed);
+    for (int i = 0; i < 20000; ++i) {
+        IntType start = std::rand() % 3000;
+        Interval interval = Interval::valueOf(start, start + 1 + std::rand() % 100);
+        if (std::rand() % 3 == 0) {
+            assert(it.remove(interval) == expected.remove(interval));
+        } else {
+            assert(it.insert(interval) == expected.insert(interval));
+        }
+        if (i % 1000 == 0) {
+            assert(it.isValid());
+        }
+    }
+    assert(it.isValid());
+    for (IntType start = 0; start < 3100; start += 7) {
+        assert(it.search(start).isValid() == expected.search(start).isValid());
+        Interval query = Interval::valueOf(start, start + 1 + start % 50);
+        set<Interval> res;
+        set<Interval> expectedRes;
+        it.overlapSearch(query, res);
+        expected.overlapSearch(query, expectedRes);
+        assert(res.size() == expectedRes.size());
+        assert(std::equal(res.begin(), res.end(), expectedRes.begin(), [](const Interval& a, const Interval& b) {
+            return a.start() == b.start() && a.end() == b.end();
+        }));
+    }
+    for (IntType start = 0; start < 3000; ++start) {
+        it.remove(Interval::valueOf(start, start + 1));
+    }
+    assert(it.empty());
+}
+
+void nestedContainmentList_Test() {
+    using std::set;
+    using std::vector;
+
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+
+    /**
+     * nested and overlapping intervals, with equal starts.
+     */
+    vector<Interval> input;
+    std::srand(13);
+    for (int i = 0; i < 3000; ++i) {
+        IntType start = std::rand() % 10000;
+        IntType length = std::rand() % 4 == 0 ? 1 + std::rand() % 5000 : 1 + std::rand() % 20;
+        input.push_back(Interval::valueOf(start, start + length));
+    }
+    NestedContainmentList<IntType> list(input.begin(), input.end());
+    assert(list.size() == input.size());
+
+    IntervalTree<IntType> tree;
+    for (auto i: input) {
+        tree.insert(i);
+    }
+    NestedContainmentList<IntType> fromTree(tree);
+
+    for (IntType start = 0; start < 16000; start += 13) {
+        Interval query = Interval::valueOf(start, start + 1 + start % 200);
+        set<Interval> expected;
+        tree.overlapSearch(query, expected);
+        set<Interval> res;
+        fromTree.overlapSearch(query, res);
+        assert(res.size() == expected.size());
+        assert(std::equal(res.begin(), res.end(), expected.begin(), [](const Interval& a, const Interval& b) {
+            return a.start() == b.start() && a.end() == b.end();
+        }));
+
+        /**
+         * set keeps one interval per start, count the range by brute force.
+         */
+        set<IntType> starts;
+        for (auto i: input) {
+            if (overlap(i, query)) {
+                starts.insert(i.start());
+            }
+        }
+        res.clear();
+        list.overlapSearch(query, res);
+        assert(res.size() == starts.size());
+    }
+
+    /**
+     * forEach visits intervals in the order of starts.
+     */
+    IntType last = 0;
+    std::size_t count = 0;
+    tree.forEach([&last, &count](const Interval& i) {
+        assert(count == 0 || last < i.start());
+        last = i.start();
+        ++count;
+    });
+    assert(count == fromTree.size());
+}
+
+void concurrentIntervalTree_Test() {
+    using std::set;
+    using std::vector;
+    using std::thread;
+    using std::atomic;
+
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+
+    /**
+     * same answers as IntervalTree.
+     */
+    {
+        IntervalTree<IntType> expected;
+        ConcurrentIntervalTree<IntType> it;
+        std::srand(7);
+        for (int i = 0; i < 2000; ++i) {
+            IntType start = std::rand() % 5000;
+            Interval interval = Interval::valueOf(start, start + 1 + std::rand() % 50);
+            assert(it.insert(interval) == expected.insert(interval));
+        }
+        for (int i = 0; i < 1000; ++i) {
+            IntType start = std::rand() % 5000;
+            Interval interval = Interval::valueOf(start, start + 1);
+            assert(it.remove(interval) == expected.remove(interval));
+        }
+        for (IntType start = 0; start < 5000; start += 37) {
+            Interval query = Interval::valueOf(start, start + 100);
+            set<Interval> res;
+            set<Interval> expectedRes;
+            it.overlapSearch(query, res);
+            expected.overlapSearch(query, expectedRes);
+            assert(res.size() == expectedRes.size());
+            assert(std::equal(res.begin(), res.end(), expectedRes.begin(), [](const Interval& a, const Interval& b) {
+                return a.start() == b.start() && a.end() == b.end();
+            }));
+            assert(it.search(start).isValid() == expected.search(start).isValid());
+        }
+        it.clear();
+        assert(it.empty());
+        assert(!it.search(Interval::valueOf(0, 1)).isValid());
+    }
+
+    /**
+     * readers run while the writer inserts and removes.
+     * Even intervals are never removed, readers must always see them.
+     */
+    {
+        ConcurrentIntervalTree<IntType> it;
+        const IntType count = 2000;
+        for (IntType i = 0; i < count; i += 2) {
+            it.insert(Interval::valueOf(i * 10, i * 10 + 5));
+        }
+        atomic<bool> done(false);
+        atomic<int> errors(0);
+        vector<thread> readers;
+        for (int r = 0; r < 4; ++r) {
+            readers.push_back(thread([&it, &done, &errors, count]() {
+                while (!done.load()) {
+                    for (IntType i = 0; i < count; i += 2) {
+                        Interval found = it.search(i * 10);
+                        if (!found.isValid() || found.end() != i * 10 + 5) {
+                            ++errors;
+                        }
+                    }
+                    set<Interval> res;
+                    it.overlapSearch(Interval::valueOf(0, count * 10), res);
+                    if (res.size() < count / 2) {
+                        ++errors;
+                    }
+                }
+            }));
+        }
+        for (int round = 0; round < 20; ++round) {
+            for (IntType i = 1; i < count; i += 2) {
+                assert(it.insert(Interval::valueOf(i * 10, i * 10 + 5)));
+            }
+            for (IntType i = 1; i < count; i += 2) {
+                assert(it.remove(Interval::valueOf(i * 10, i * 10 + 5)));
+            }
+        }
+        done.store(true);
+        for (auto& reader: readers) {
+            reader.join();
+        }
+        assert(errors.load() == 0);
+    }
+
+    /**
+     * a write that throws part way leaves the published version intact,
+     * later writes must not retire nodes it still references.
+     */
+    {
+        ConcurrentIntervalTree<IntType, CountingExtent> it;
+        const IntType count = 100;
+        for (IntType i = 0; i < count; i += 2) {
+            it.insert(CountingExtent(i * 10, i * 10 + 5));
+        }
+        int failed = 0;
+        for (IntType i = 1; i < count; i += 2) {
+            for (int limit = 0; ; ++limit) {
+                CountingExtent::copies = 0;
+                CountingExtent::limit = limit;
+                bool inserted = false;
+                try {
+                    inserted = it.insert(CountingExtent(i * 10, i * 10 + 5));
+                } catch (const std::bad_alloc&) {
+                    ++failed;
+                }
+                CountingExtent::limit = -1;
+                if (inserted) {
+                    break;
+                }
+                assert(!it.search(i * 10).isValid());
+            }
+            for (int limit = 0; ; ++limit) {
+                CountingExtent::copies = 0;
+                CountingExtent::limit = limit;
+                bool removed = false;
+                try {
+                    removed = it.remove(CountingExtent(i * 10 - 10, i * 10 - 5));
+                } catch (const std::bad_alloc&) {
+                    ++failed;
+                }
+                CountingExtent::limit = -1;
+                if (removed) {
+                    break;
+                }
+                assert(it.search(i * 10 - 10).isValid());
+            }
+            assert(it.insert(CountingExtent(i * 10 - 10, i * 10 - 5)));
+        }
+        assert(failed > 0);
+        for (IntType i = 0; i < count; ++i) {
+            assert(it.search(i * 10).isValid());
+        }
+        set<CountingExtent> res;
+        it.overlapSearch(CountingExtent(0, count * 10), res);
+        assert(res.size() == count);
+    }
+}
+
+void persistentIntervalTree_Test() {
+    using std::set;
+    using std::vector;
+
+    typedef unsigned long IntType;
+    typedef IntervalT<IntType> Interval;
+    typedef PersistentIntervalTree<IntType> Tree;
+
+    Tree it;
+    vector<Tree::Snapshot> snapshots;
+    vector<set<IntType>> expected;
+    set<IntType> starts;
+
+    std::srand(11);
+    for (int round = 0; round < 20; ++round) {
+        snapshots.push_back(it.snapshot());
+        expected.push_back(starts);
+        for (int i = 0; i < 100; ++i) {
+            IntType start = std::rand() % 1000;
+            Interval interval = Interval::valueOf(start, start + 10);
+            if (std::rand() % 3 == 0) {
+                assert(it.remove(interval) == (starts.erase(start) == 1));
+            } else {
+                assert(it.insert(interval) == starts.insert(start).second);
+            }
+        }
+    }
+
+    /**
+     * each snapshot still answers with the content of its version.
+     */
+    for (std::size_t v = 0; v < snapshots.size(); ++v) {
+        set<Interval> res;
+        snapshots[v].overlapSearch(Interval::valueOf(0, 2000), res);
+        assert(res.size() == expected[v].size());
+        for (IntType start = 0; start < 1000; ++start) {
+            assert(snapshots[v].search(start).isValid() == (expected[v].count(start) == 1));
+        }
+        res.clear();
+        snapshots[v].overlapSearch(Interval::valueOf(500, 505), res);
+        for (auto i: res) {
+            assert(i.start() > 490 && i.start() < 505);
+        }
+    }
+    assert(snapshots[3].version() < snapshots[4].version());
+    assert(snapshots[0].empty());
+
+    /**
+     * go back to an old version, the snapshots of newer versions are not affected.
+     */
+    Tree old(snapshots[5]);
+    old.insert(Interval::valueOf(5000, 5010));
+    assert(old.search(5000UL).isValid());
+    assert(!snapshots[5].search(5000UL).isValid());
+    assert(!it.search(5000UL).isValid());
+
+    /**
+     * dead versions are freed with their last snapshot.
+     */
+    snapshots.erase(snapshots.begin(), snapshots.begin() + 10);
+    it.clear();
+    assert(it.empty());
+    assert(!snapshots.back().empty());
+
+    /**
+     * a key of length 0 is not valid, but it is stored like any other.
+     */
+    Interval point = Interval::valueOf(7000, 7000);
+    assert(it.insert(point));
+    assert(!it.insert(point));
+    set<Interval> res;
+    it.overlapSearch(Interval::valueOf(6990, 7010), res);
+    assert(res.size() == 1);
+    assert(it.remove(point));
+    assert(!it.remove(point));
+    assert(it.empty());
+
+    /**
+     * the Interval type does not need isValid().
+     */
+    PersistentIntervalTree<IntType, ExtentT<IntType>> extents;
+    assert(extents.insert(ExtentT<IntType>::valueOf(10, 20)));
+    assert(!extents.insert(ExtentT<IntType>::valueOf(10, 20)));
+    assert(extents.remove(ExtentT<IntType>::valueOf(10, 20)));
+    assert(extents.empty());
+}
+
 void demoOverlap() {
     using std::cout;
     using std::endl;
@@ -784,7 +2586,34 @@ int main(int argc, char **argv) {
     interval_set_intersect_Test1();
     interval_set_union_Test();
     interval_set_union_Test1();
+    interval_algebra_Test();
     intervalTree_Test();
+    intervalTree_clone_move_Test();
+    intervalTree_remove_Test();
+    intervalTree_emplace_Test();
+    intervalTree_allocator_Test();
+    intervalTree_batch_Test();
+    intervalTree_vector_Test();
+    intervalTree_expire_Test();
+    intervalTree_split_join_Test();
+    intervalTree_merge_Test();
+    overlapJoin_Test();
+    intervalTree_finger_Test();
+    intrusiveIntervalTree_Test();
+    intervalTree_handle_Test();
+    intervalCoverage_Test();
+    occupancyBitmap_Test();
+    overlapCache_Test();
+    intervalTree_augmentation_Test();
+    intervalTree_balance_Test<RedBlackBalance>(46);
+    intervalTree_balance_Test<AvlBalance>(47);
+    intervalTree_balance_Test<WavlBalance>(48);
+    intervalTree_balance_Test<TreapBalance>(49);
+    intervalBTree_Test<IntervalBTree<unsigned long>>(5);
+    intervalBTree_Test<IntervalBTree<unsigned long, IntervalT<unsigned long>, 4>>(6);
+    nestedContainmentList_Test();
+    concurrentIntervalTree_Test();
+    persistentIntervalTree_Test();
     demoOverlap();
 	return 0;
 }